@@ -19,6 +19,22 @@
 
 #include "type_multiset.hpp"
 
+// With QUANTITY_COUNT_OPERATIONS defined, each operator counts itself
+// (see quantity_counting.hpp), otherwise QUANTITY_COUNT is empty,
+// so the operators are the same as without the counting code.
+///@cond INTERNAL
+#ifdef QUANTITY_COUNT_OPERATIONS
+   #include "quantity_counting.hpp"
+   #define QUANTITY_COUNT( op, L, R )                                  \
+      if( ! __builtin_is_constant_evaluated() ){                        \
+         quantity_counting::count<                                      \
+            quantity_counting::operation::op, L, R >();                 \
+      }
+#else
+   #define QUANTITY_COUNT( op, L, R )
+#endif
+///@endcond
+
 // this file contains Doxygen lines
 /// @file
 
@@ -249,7 +265,45 @@ public:
    /// This value is used to create other quantity values.
    static constexpr const quantity_implementation one = 
       quantity_implementation( 1 );
-   
+
+
+   // =======================================================================
+   //
+   // base value access
+   //
+   // =======================================================================
+
+   /// the base type
+   using value_type = V;
+
+   /// the tag type (a type multiset)
+   using tags = T;
+
+   /// create a quantity from a raw base value
+   ///
+   /// This bypasses the ( one * value ) idiom.
+   /// It is intended for bulk storage, serialization and
+   /// the array algorithms, which must move many base values
+   /// into quantities without the overhead of a multiplication.
+   ///@cond INTERNAL
+   __attribute__((always_inline))
+   ///@endcond
+   static constexpr quantity_implementation from_raw( const V & value ){
+      return quantity_implementation( value );
+   }
+
+   /// the raw base value
+   ///
+   /// This bypasses the ( quantity / one ) idiom.
+   /// Like from_raw(), it is intended for code that stores
+   /// or moves base values, not for computations.
+   ///@cond INTERNAL
+   __attribute__((always_inline))
+   ///@endcond
+   constexpr const V & raw() const {
+      return value;
+   }
+
 
    // =======================================================================
    //
@@ -321,6 +375,7 @@ public:
    __attribute__((always_inline))
    ///@endcond
    {
+      QUANTITY_COUNT( plus, T, void );
       return quantity_implementation< 
          decltype( + value), 
          T 
@@ -343,6 +398,7 @@ public:
    constexpr auto operator+( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( add, T, U );
       return quantity_implementation< 
          decltype( value + right.value ), 
          T 
@@ -365,6 +421,7 @@ public:
    quantity_implementation & operator+=( 
       const quantity_implementation< W, U > & right 
    ){
+      QUANTITY_COUNT( add_assign, T, U );
       value += right.value;
       return *this;
    }
@@ -386,6 +443,7 @@ public:
    __attribute__((always_inline))
    ///@endcond
    {
+      QUANTITY_COUNT( minus, T, void );
       return quantity_implementation< 
          decltype( - value ), 
          T 
@@ -408,6 +466,7 @@ public:
    constexpr auto operator-( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( subtract, T, U );
       return quantity_implementation< 
          decltype( value - right.value ), 
          T 
@@ -430,6 +489,7 @@ public:
    quantity_implementation & operator-=( 
       const quantity_implementation< W, U > & right 
    ){
+      QUANTITY_COUNT( subtract_assign, T, U );
       value -= right.value;
       return *this;
    }
@@ -453,6 +513,7 @@ public:
    __attribute__((always_inline))
    ///@endcond
    constexpr auto operator*( const X & right ) const {
+      QUANTITY_COUNT( multiply, T, type_multiset::empty );
       return quantity_implementation< 
          decltype( value * right ), 
          T  
@@ -473,6 +534,7 @@ public:
    __attribute__((always_inline))
    ///@endcond
    constexpr auto _reverse_multiply( const X & left ) const {
+      QUANTITY_COUNT( multiply, type_multiset::empty, T );
       return quantity_implementation< 
          decltype( left * value ), 
          T  
@@ -494,6 +556,7 @@ public:
    constexpr auto operator*( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( multiply, T, U );
       return quantity_implementation< 
          decltype( value * right.value ), 
          type_multiset::add< T, U >
@@ -521,6 +584,7 @@ public:
    __attribute__((always_inline))
    ///@endcond
    constexpr auto operator/( const X & right ) const {
+      QUANTITY_COUNT( divide, T, type_multiset::empty );
       return quantity_implementation< 
          decltype( value / right ), 
          T  
@@ -542,6 +606,7 @@ public:
    constexpr auto _reverse_divide( 
       const X & left
    ) const {
+      QUANTITY_COUNT( divide, type_multiset::empty, T );
       return ::quantity_implementation< 
          decltype( left / value ), 
          type_multiset::multiply< T, -1 >  
@@ -563,6 +628,7 @@ public:
    constexpr auto operator/( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( divide, T, U );
       return quantity_implementation< 
          decltype( value / right.value ), 
          type_multiset::add< T, type_multiset::multiply< U, -1 > >
@@ -587,6 +653,7 @@ public:
    constexpr auto operator/( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( divide, T, U );
       return value / right.value;
    }
    
@@ -611,6 +678,7 @@ public:
    constexpr auto operator==( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( compare, T, U );
       return value == right.value;
    }
 
@@ -628,6 +696,7 @@ public:
    constexpr auto operator!=( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( compare, T, U );
       return value != right.value;
    }
    
@@ -652,6 +721,7 @@ public:
    constexpr auto operator>( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( compare, T, U );
       return value > right.value;
    }
 
@@ -669,6 +739,7 @@ public:
    constexpr auto operator>=( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( compare, T, U );
       return value >= right.value;
    }
 
@@ -693,6 +764,7 @@ public:
    constexpr auto operator<( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( compare, T, U );
       return value < right.value;
    }
 
@@ -710,6 +782,7 @@ public:
    constexpr auto operator<=( 
       const quantity_implementation< W, U > & right 
    ) const {
+      QUANTITY_COUNT( compare, T, U );
       return value <= right.value;
    }
      
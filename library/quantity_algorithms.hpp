@@ -0,0 +1,567 @@
+// ==========================================================================
+//
+// quantity_algorithms.hpp
+//
+// algorithms on spans of quantities, with the tag type of the result
+// derived from the operation
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_algorithms_hpp
+#define quantity_algorithms_hpp
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+#include "quantity_parallel.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_algorithms
+///
+/// The quantity algorithms work on spans of quantities.
+/// They live in the namespace quantity_algorithms.
+/// The output span must have the tag type that the operation produces,
+/// otherwise the call doesn't compile.
+/// Arrays larger than quantity_parallel::grain are split over threads,
+/// each thread runs a plain loop over the base values.
+/// For floating point base types, the split can change the rounding
+/// of sums compared to a single left-to-right pass.
+///
+/// The available functionality is:
+///
+/// inclusive_scan( in, out )
+///    out[ i ] = in[ 0 ] + ... + in[ i ]
+///
+/// exclusive_scan( in, out )
+///    out[ i ] = in[ 0 ] + ... + in[ i - 1 ], out[ 0 ] is zero
+///
+/// adjacent_difference( in, out )
+///    out[ 0 ] = in[ 0 ], out[ i ] = in[ i ] - in[ i - 1 ]
+///    (the inverse of inclusive_scan)
+///
+/// integrate( in, dt, out )
+///    the running integral of samples taken at intervals of dt,
+///    using the trapezoid rule: out[ 0 ] is zero,
+///    out[ i ] = out[ i - 1 ] + ( in[ i - 1 ] + in[ i ] ) * dt / 2.
+///    The tag type of out is that of in * dt.
+///
+/// differentiate( in, dt, out )
+///    the difference quotients of samples taken at intervals of dt:
+///    out[ i ] = ( in[ i + 1 ] - in[ i ] ) / dt.
+///    out has one element less than in.
+///    The tag type of out is that of in / dt.
+///
+/// Except for differentiate, out must have (at least) as many
+/// elements as in.
+/// The scans and integrate can be done in place (out is in).
+///
+/// The following algorithms take an execution policy as first argument:
+/// quantity_parallel::seq or quantity_parallel::par, or (when <execution>
+/// is included first) one of the std::execution policies.
+/// All parallel policies use the quantity_parallel thread pool,
+/// std::execution::seq and std::execution::unseq run in the calling
+/// thread.
+///
+/// transform( policy, in, out, f )
+///    out[ i ] = f( in[ i ] )
+///    The tag type of out is that of the result of f.
+///
+/// transform( policy, in1, in2, out, f )
+///    out[ i ] = f( in1[ i ], in2[ i ] )
+///    The tag type of out is that of the result of f.
+///
+/// reduce( policy, in )
+///    the sum of the elements, zero when in is empty
+///
+/// reduce( policy, in, init, op )
+///    init op in[ 0 ] op ... op in[ n - 1 ], op must be associative
+///
+/// transform_reduce( policy, in1, in2 )
+///    the sum of in1[ i ] * in2[ i ],
+///    the tag type is that of in1[ 0 ] * in2[ 0 ]
+///
+/// transform_reduce( policy, in, init, reduce_op, transform_op )
+///    init reduce_op transform_op( in[ 0 ] ) reduce_op ...,
+///    reduce_op must be associative
+///
+/// min_element( policy, in )
+///    (a pointer to) the first smallest element, in.end() when empty
+///
+/// minmax( policy, in )
+///    a std::pair of the smallest and the largest element,
+///    a pair of zeros when in is empty
+///
+/// count_if( policy, in, predicate )
+///    the number of elements for which predicate( element ) is true
+//
+// ==========================================================================
+
+namespace quantity_algorithms {
+
+///@cond INTERNAL
+
+// ==========================================================================
+//
+// the chunked parallel scan
+//
+// First each chunk sums its own terms, then the chunk totals are
+// turned into the starting sums of the chunks, and then each chunk
+// scans its terms again, starting from its starting sum.
+// Element i of out is written after term( i ) and finish( sum, i )
+// have been evaluated, and term( i ) and finish( sum, i ) use only
+// element i of the input, so out can be the input.
+//
+// ==========================================================================
+
+template< bool Exclusive, typename S, typename Term, typename Finish, typename R >
+void scan_chunk(
+   std::size_t begin, std::size_t end,
+   S sum, Term & term, Finish & finish, R * out
+){
+   for( std::size_t i = begin; i < end; ++i ){
+      if( Exclusive ){
+         const S t = term( i );
+         out[ i ] = finish( sum, i );
+         sum += t;
+      } else {
+         sum += term( i );
+         out[ i ] = finish( sum, i );
+      }
+   }
+}
+
+template< bool Exclusive, typename S, typename Term, typename Finish, typename R >
+void scan( std::size_t n, Term term, Finish finish, R * out ){
+   const auto count = quantity_parallel::chunks( n );
+   if( count == 1 ){
+      scan_chunk< Exclusive >( 0, n, S( 0 ), term, finish, out );
+      return;
+   }
+
+   std::vector< S > starts( count, S( 0 ) );
+   quantity_parallel::for_chunks( n,
+      [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+         S sum = S( 0 );
+         for( std::size_t i = begin; i < end; ++i ){
+            sum += term( i );
+         }
+         starts[ c ] = sum;
+      } );
+
+   S sum = S( 0 );
+   for( auto & start : starts ){
+      S total = start;
+      start = sum;
+      sum += total;
+   }
+
+   quantity_parallel::for_chunks( n,
+      [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+         scan_chunk< Exclusive >( begin, end, starts[ c ], term, finish, out );
+      } );
+}
+
+///@endcond
+
+
+// ==========================================================================
+//
+// scans
+//
+// ==========================================================================
+
+/// inclusive prefix sum
+template< typename Q, typename R >
+///@cond INTERNAL
+requires quantity_concepts::compatible< Q, R >
+///@endcond
+void inclusive_scan( quantity_span< Q > in, quantity_span< R > out ){
+   using S = typename R::value_type;
+   const auto * src = in.raw();
+   scan< false, S >(
+      in.size(),
+      [ src ]( std::size_t i ){ return src[ i ]; },
+      []( const S & sum, std::size_t ){ return sum; },
+      out.raw() );
+}
+
+/// exclusive prefix sum
+template< typename Q, typename R >
+///@cond INTERNAL
+requires quantity_concepts::compatible< Q, R >
+///@endcond
+void exclusive_scan( quantity_span< Q > in, quantity_span< R > out ){
+   using S = typename R::value_type;
+   const auto * src = in.raw();
+   scan< true, S >(
+      in.size(),
+      [ src ]( std::size_t i ){ return src[ i ]; },
+      []( const S & sum, std::size_t ){ return sum; },
+      out.raw() );
+}
+
+/// running trapezoid integral of samples at intervals dt
+template< typename Q, typename W, typename U, typename R >
+///@cond INTERNAL
+requires type_multiset::equal<
+   typename R::tags,
+   type_multiset::add< typename Q::tags, U >
+>::value
+///@endcond
+void integrate(
+   quantity_span< Q > in,
+   const quantity_implementation< W, U > & dt,
+   quantity_span< R > out
+){
+   if( in.empty() ){
+      return;
+   }
+   using S = decltype( in.raw()[ 0 ] + in.raw()[ 0 ] );
+   const auto * src = in.raw();
+   const auto step = dt.raw();
+   
+   // in[ 0 ] + 2 in[ 1 ] + ... + 2 in[ i - 1 ] + in[ i ], from the 
+   // prefix sum of in, which uses only element i (so out can be in)
+   const S first = src[ 0 ];
+   scan< false, S >(
+      in.size(),
+      [ src ]( std::size_t i ){ return S( src[ i ] ); },
+      [ src, step, first ]( const S & sum, std::size_t i ){ 
+         return ( ( sum + sum - src[ i ] - first ) * step ) / 2; },
+      out.raw() );
+}
+
+
+// ==========================================================================
+//
+// differences
+//
+// ==========================================================================
+
+/// differences between adjacent elements
+template< typename Q, typename R >
+///@cond INTERNAL
+requires quantity_concepts::compatible< Q, R >
+///@endcond
+void adjacent_difference( quantity_span< Q > in, quantity_span< R > out ){
+   if( in.empty() ){
+      return;
+   }
+   const auto * __restrict__ src = in.raw();
+   auto * __restrict__ dst = out.raw();
+   dst[ 0 ] = src[ 0 ];
+   quantity_parallel::for_chunks( in.size() - 1,
+      [ src, dst ]( std::size_t, std::size_t begin, std::size_t end ){
+         for( std::size_t i = begin + 1; i < end + 1; ++i ){
+            dst[ i ] = src[ i ] - src[ i - 1 ];
+         }
+      } );
+}
+
+/// difference quotients of samples at intervals dt
+template< typename Q, typename W, typename U, typename R >
+///@cond INTERNAL
+requires type_multiset::equal<
+   typename R::tags,
+   type_multiset::add< typename Q::tags, type_multiset::multiply< U, -1 > >
+>::value
+///@endcond
+void differentiate(
+   quantity_span< Q > in,
+   const quantity_implementation< W, U > & dt,
+   quantity_span< R > out
+){
+   if( in.size() < 2 ){
+      return;
+   }
+   const auto * __restrict__ src = in.raw();
+   auto * __restrict__ dst = out.raw();
+   const auto step = dt.raw();
+   quantity_parallel::for_chunks( in.size() - 1,
+      [ src, dst, step ]( std::size_t, std::size_t begin, std::size_t end ){
+         for( std::size_t i = begin; i < end; ++i ){
+            dst[ i ] = ( src[ i + 1 ] - src[ i ] ) / step;
+         }
+      } );
+}
+
+
+// ==========================================================================
+//
+// algorithms with an execution policy
+//
+// ==========================================================================
+
+/// apply f to each element
+template< typename P, typename Q, typename R, typename F >
+///@cond INTERNAL
+requires 
+   quantity_parallel::execution_policy< P >
+   && quantity_concepts::compatible< 
+      R, decltype( std::declval< F & >()( std::declval< Q & >() ) ) >
+///@endcond
+void transform( 
+   P && policy, quantity_span< Q > in, quantity_span< R > out, F f 
+){
+   const auto n = in.size();
+   quantity_parallel::for_chunks( n, quantity_parallel::chunks( policy, n ),
+      [ & ]( std::size_t, std::size_t begin, std::size_t end ){
+         auto * dst = out.raw();
+         for( std::size_t i = begin; i < end; ++i ){
+            dst[ i ] = f( in[ i ] ).raw();
+         }
+      } );
+}
+
+/// apply f to each pair of elements
+template< typename P, typename Q1, typename Q2, typename R, typename F >
+///@cond INTERNAL
+requires 
+   quantity_parallel::execution_policy< P >
+   && quantity_concepts::compatible< 
+      R, decltype( std::declval< F & >()( 
+         std::declval< Q1 & >(), std::declval< Q2 & >() ) ) >
+///@endcond
+void transform( 
+   P && policy, 
+   quantity_span< Q1 > in1, quantity_span< Q2 > in2, 
+   quantity_span< R > out, F f 
+){
+   const auto n = in1.size();
+   quantity_parallel::for_chunks( n, quantity_parallel::chunks( policy, n ),
+      [ & ]( std::size_t, std::size_t begin, std::size_t end ){
+         auto * dst = out.raw();
+         for( std::size_t i = begin; i < end; ++i ){
+            dst[ i ] = f( in1[ i ], in2[ i ] ).raw();
+         }
+      } );
+}
+
+/// the sum of the elements
+template< typename P, typename Q >
+///@cond INTERNAL
+requires quantity_parallel::execution_policy< P >
+///@endcond
+auto reduce( P && policy, quantity_span< Q > in ){
+   using quantity_type = typename quantity_span< Q >::quantity_type;
+   using V = typename quantity_type::value_type;
+   const auto n = in.size();
+   const auto count = quantity_parallel::chunks( policy, n );
+   std::vector< V > sums( count, V( 0 ) );
+   quantity_parallel::for_chunks( n, count,
+      [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+         const auto * src = in.raw();
+         V sum = V( 0 );
+         for( std::size_t i = begin; i < end; ++i ){
+            sum += src[ i ];
+         }
+         sums[ c ] = sum;
+      } );
+   V sum = V( 0 );
+   for( const auto & s : sums ){
+      sum += s;
+   }
+   return quantity_type::from_raw( sum );
+}
+
+/// the elements combined by op, starting with init
+template< typename P, typename Q, typename I, typename Op >
+///@cond INTERNAL
+requires quantity_parallel::execution_policy< P >
+///@endcond
+I reduce( P && policy, quantity_span< Q > in, I init, Op op ){
+   const auto n = in.size();
+   const auto count = quantity_parallel::chunks( policy, n );
+   std::vector< I > partials( count, init );
+   quantity_parallel::for_chunks( n, count,
+      [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+         if( begin == end ){
+            return;
+         }
+         I partial = in[ begin ];
+         for( std::size_t i = begin + 1; i < end; ++i ){
+            partial = op( partial, in[ i ] );
+         }
+         partials[ c ] = partial;
+      } );
+   if( n > 0 ){
+      for( const auto & partial : partials ){
+         init = op( init, partial );
+      }
+   }
+   return init;
+}
+
+/// the sum of the products of the pairs of elements
+template< typename P, typename Q1, typename Q2 >
+///@cond INTERNAL
+requires quantity_parallel::execution_policy< P >
+///@endcond
+auto transform_reduce( 
+   P && policy, quantity_span< Q1 > in1, quantity_span< Q2 > in2 
+){
+   using S = decltype( in1.raw()[ 0 ] * in2.raw()[ 0 ] );
+   using result_type = quantity_implementation< 
+      S, 
+      type_multiset::add< typename Q1::tags, typename Q2::tags > >;
+   const auto n = in1.size();
+   const auto count = quantity_parallel::chunks( policy, n );
+   std::vector< S > sums( count, S( 0 ) );
+   quantity_parallel::for_chunks( n, count,
+      [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+         const auto * __restrict__ a = in1.raw();
+         const auto * __restrict__ b = in2.raw();
+         S sum = S( 0 );
+         for( std::size_t i = begin; i < end; ++i ){
+            sum += a[ i ] * b[ i ];
+         }
+         sums[ c ] = sum;
+      } );
+   S sum = S( 0 );
+   for( const auto & s : sums ){
+      sum += s;
+   }
+   return result_type::from_raw( sum );
+}
+
+/// the transformed elements combined by reduce_op, starting with init
+template< 
+   typename P, typename Q, typename I, typename ReduceOp, typename TransformOp >
+///@cond INTERNAL
+requires quantity_parallel::execution_policy< P >
+///@endcond
+I transform_reduce( 
+   P && policy, quantity_span< Q > in, I init, 
+   ReduceOp reduce_op, TransformOp transform_op 
+){
+   const auto n = in.size();
+   const auto count = quantity_parallel::chunks( policy, n );
+   std::vector< I > partials( count, init );
+   quantity_parallel::for_chunks( n, count,
+      [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+         if( begin == end ){
+            return;
+         }
+         I partial = transform_op( in[ begin ] );
+         for( std::size_t i = begin + 1; i < end; ++i ){
+            partial = reduce_op( partial, transform_op( in[ i ] ) );
+         }
+         partials[ c ] = partial;
+      } );
+   if( n > 0 ){
+      for( const auto & partial : partials ){
+         init = reduce_op( init, partial );
+      }
+   }
+   return init;
+}
+
+/// the first smallest element
+template< typename P, typename Q >
+///@cond INTERNAL
+requires quantity_parallel::execution_policy< P >
+///@endcond
+Q * min_element( P && policy, quantity_span< Q > in ){
+   const auto n = in.size();
+   if( n == 0 ){
+      return in.end();
+   }
+   const auto count = quantity_parallel::chunks( policy, n );
+   std::vector< std::size_t > mins( count, 0 );
+   quantity_parallel::for_chunks( n, count,
+      [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+         const auto * src = in.raw();
+         auto min = begin;
+         for( std::size_t i = begin + 1; i < end; ++i ){
+            if( src[ i ] < src[ min ] ){
+               min = i;
+            }
+         }
+         mins[ c ] = min;
+      } );
+   auto min = mins[ 0 ];
+   for( auto m : mins ){
+      if( in.raw()[ m ] < in.raw()[ min ] ){
+         min = m;
+      }
+   }
+   return in.begin() + min;
+}
+
+/// the smallest and the largest element
+template< typename P, typename Q >
+///@cond INTERNAL
+requires quantity_parallel::execution_policy< P >
+///@endcond
+auto minmax( P && policy, quantity_span< Q > in ){
+   using quantity_type = typename quantity_span< Q >::quantity_type;
+   using V = typename quantity_type::value_type;
+   const auto n = in.size();
+   if( n == 0 ){
+      return std::make_pair( 
+         quantity_type::from_raw( V( 0 ) ), quantity_type::from_raw( V( 0 ) ) );
+   }
+   const auto count = quantity_parallel::chunks( policy, n );
+   std::vector< std::pair< V, V > > partials( 
+      count, std::make_pair( in.raw()[ 0 ], in.raw()[ 0 ] ) );
+   quantity_parallel::for_chunks( n, count,
+      [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+         const auto * src = in.raw();
+         V min = src[ begin ], max = src[ begin ];
+         for( std::size_t i = begin + 1; i < end; ++i ){
+            min = src[ i ] < min ? src[ i ] : min;
+            max = max < src[ i ] ? src[ i ] : max;
+         }
+         partials[ c ] = std::make_pair( min, max );
+      } );
+   auto result = partials[ 0 ];
+   for( const auto & p : partials ){
+      result.first  = p.first  < result.first  ? p.first  : result.first;
+      result.second = result.second < p.second ? p.second : result.second;
+   }
+   return std::make_pair( 
+      quantity_type::from_raw( result.first ), 
+      quantity_type::from_raw( result.second ) );
+}
+
+/// the number of elements for which predicate is true
+template< typename P, typename Q, typename F >
+///@cond INTERNAL
+requires quantity_parallel::execution_policy< P >
+///@endcond
+std::size_t count_if( P && policy, quantity_span< Q > in, F predicate ){
+   const auto n = in.size();
+   const auto count = quantity_parallel::chunks( policy, n );
+   std::vector< std::size_t > counts( count, 0 );
+   quantity_parallel::for_chunks( n, count,
+      [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+         std::size_t k = 0;
+         for( std::size_t i = begin; i < end; ++i ){
+            k += predicate( in[ i ] ) ? 1 : 0;
+         }
+         counts[ c ] = k;
+      } );
+   std::size_t k = 0;
+   for( auto x : counts ){
+      k += x;
+   }
+   return k;
+}
+
+}; // namespace quantity_algorithms
+
+#endif // ifndef quantity_algorithms_hpp
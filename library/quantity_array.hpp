@@ -0,0 +1,228 @@
+// ==========================================================================
+//
+// quantity_array.hpp
+//
+// contiguous sequences of quantities: a non-owning span
+// and an owning array
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_array_hpp
+#define quantity_array_hpp
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "quantity.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+
+// ==========================================================================
+//
+// quantity span
+//
+// ==========================================================================
+
+/// non-owning view of a contiguous sequence of quantities
+//
+/// The element type Q is a quantity_implementation< V, T >,
+/// or a const quantity_implementation< V, T > for a read-only view.
+/// A span of Q converts implicitly to a span of const Q.
+///
+/// A quantity has the same size and alignment as its base type,
+/// so the raw() of a span is the same memory seen as an
+/// array of base values.
+/// The array algorithms use this to run plain (vectorizable) loops.
+template< typename Q >
+class quantity_span {
+public:
+
+   /// the (possibly const) quantity type of the elements
+   using element_type  = Q;
+
+   /// the quantity type of the elements
+   using quantity_type = typename std::remove_const< Q >::type;
+
+   /// the base type of the elements
+   using value_type    = typename quantity_type::value_type;
+
+   /// the tag type of the elements
+   using tags          = typename quantity_type::tags;
+
+   /// the base type as seen through raw()
+   using raw_type      = typename std::conditional<
+      std::is_const< Q >::value, const value_type, value_type >::type;
+
+   static_assert(
+      sizeof( quantity_type ) == sizeof( value_type )
+      && alignof( quantity_type ) == alignof( value_type ),
+      "a quantity must have the layout of its base type" );
+
+private:
+
+   Q * first;
+   std::size_t n;
+
+public:
+
+   /// create an empty span
+   constexpr quantity_span():
+      first( nullptr ), n( 0 )
+   {}
+
+   /// create a span from a pointer and a number of elements
+   constexpr quantity_span( Q * data, std::size_t size ):
+      first( data ), n( size )
+   {}
+
+   /// create a read-only span from a writeable one
+   template< typename R >
+   ///@cond INTERNAL
+   requires std::is_same< const R, Q >::value
+   ///@endcond
+   constexpr quantity_span( const quantity_span< R > & right ):
+      first( right.data() ), n( right.size() )
+   {}
+
+   /// the first element
+   constexpr Q * data() const { return first; }
+
+   /// the number of elements
+   constexpr std::size_t size() const { return n; }
+
+   /// whether the span has no elements
+   constexpr bool empty() const { return n == 0; }
+
+   /// iterator to the first element
+   constexpr Q * begin() const { return first; }
+
+   /// iterator just beyond the last element
+   constexpr Q * end() const { return first + n; }
+
+   /// element access (not range-checked)
+   constexpr Q & operator[]( std::size_t i ) const { return first[ i ]; }
+
+   /// the span of count elements that starts at offset
+   constexpr quantity_span subspan(
+      std::size_t offset, std::size_t count
+   ) const {
+      return quantity_span( first + offset, count );
+   }
+
+   /// the elements, seen as an array of base values
+   raw_type * raw() const {
+      return reinterpret_cast< raw_type * >( first );
+   }
+};
+
+
+// ==========================================================================
+//
+// quantity array
+//
+// ==========================================================================
+
+/// owning, resizeable, contiguous sequence of quantities
+//
+/// The elements are quantity_implementation< V, T > values.
+/// A quantity_array converts implicitly to a (read-only or
+/// writeable) span of its elements.
+template< typename V, typename T >
+class quantity_array {
+public:
+
+   /// the quantity type of the elements
+   using quantity_type = quantity_implementation< V, T >;
+
+   /// the base type of the elements
+   using value_type    = V;
+
+   /// the tag type of the elements
+   using tags          = T;
+
+private:
+
+   std::vector< quantity_type > elements;
+
+public:
+
+   /// create an empty array
+   quantity_array()
+   {}
+
+   /// create an array of size elements, all equal to fill
+   explicit quantity_array(
+      std::size_t size,
+      const quantity_type & fill = quantity_type::from_raw( V() )
+   ):
+      elements( size, fill )
+   {}
+
+   /// the first element
+   quantity_type * data(){ return elements.data(); }
+   const quantity_type * data() const { return elements.data(); }
+
+   /// the number of elements
+   std::size_t size() const { return elements.size(); }
+
+   /// whether the array has no elements
+   bool empty() const { return elements.empty(); }
+
+   /// change the number of elements, new elements are equal to fill
+   void resize(
+      std::size_t size,
+      const quantity_type & fill = quantity_type::from_raw( V() )
+   ){
+      elements.resize( size, fill );
+   }
+
+   /// reserve memory for at least size elements
+   void reserve( std::size_t size ){ elements.reserve( size ); }
+
+   /// append an element
+   void push_back( const quantity_type & x ){ elements.push_back( x ); }
+
+   /// remove all elements
+   void clear(){ elements.clear(); }
+
+   /// iterators
+   quantity_type * begin(){ return data(); }
+   quantity_type * end(){ return data() + size(); }
+   const quantity_type * begin() const { return data(); }
+   const quantity_type * end() const { return data() + size(); }
+
+   /// element access (not range-checked)
+   quantity_type & operator[]( std::size_t i ){ return elements[ i ]; }
+   const quantity_type & operator[]( std::size_t i ) const {
+      return elements[ i ];
+   }
+
+   /// the elements as a writeable span
+   quantity_span< quantity_type > span(){
+      return quantity_span< quantity_type >( data(), size() );
+   }
+
+   /// the elements as a read-only span
+   quantity_span< const quantity_type > span() const {
+      return quantity_span< const quantity_type >( data(), size() );
+   }
+
+   /// implicit conversions to spans
+   operator quantity_span< quantity_type >(){ return span(); }
+   operator quantity_span< const quantity_type >() const { return span(); }
+
+   /// the elements, seen as an array of base values
+   V * raw(){ return span().raw(); }
+   const V * raw() const { return span().raw(); }
+};
+
+#endif // ifndef quantity_array_hpp
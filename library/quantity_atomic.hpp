@@ -0,0 +1,169 @@
+// ==========================================================================
+//
+// quantity_atomic.hpp
+//
+// a quantity that can be accessed and updated atomically
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_atomic_hpp
+#define quantity_atomic_hpp
+
+#include <atomic>
+#include <type_traits>
+#include "quantity.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+
+// ==========================================================================
+//
+// atomic quantity
+//
+// ==========================================================================
+
+/// quantity_implementation< V, T > with atomic operations
+//
+/// This is a std::atomic< V > for the base value, with an interface
+/// in terms of quantities: load() and exchange() return a quantity,
+/// store(), exchange() and compare_exchange_*() take a quantity.
+/// fetch_add() and fetch_sub() take a quantity of the same
+/// dimension (an equal tag type) and return the previous value.
+///
+/// For an integer base value fetch_add() and fetch_sub() are those
+/// of std::atomic, for a floating point base value (which
+/// std::atomic< V > in C++17 doesn't support) they are
+/// compare-exchange loops.
+/// A quantity_atomic is lock-free when std::atomic< V > is.
+template< typename V, typename T >
+class quantity_atomic {
+public:
+
+   /// the quantity type of the value
+   using quantity_type = quantity_implementation< V, T >;
+
+   /// whether the operations are always lock-free
+   static constexpr bool is_always_lock_free =
+      std::atomic< V >::is_always_lock_free;
+
+private:
+
+   std::atomic< V > value;
+
+public:
+
+   /// create an atomic quantity with base value 0
+   quantity_atomic():
+      value( V( 0 ) )
+   {}
+
+   /// create an atomic quantity with the value q
+   explicit quantity_atomic( const quantity_type & q ):
+      value( q.raw() )
+   {}
+
+   quantity_atomic( const quantity_atomic & ) = delete;
+   quantity_atomic & operator=( const quantity_atomic & ) = delete;
+
+   /// whether the operations of this object are lock-free
+   bool is_lock_free() const {
+      return value.is_lock_free();
+   }
+
+   /// the current value
+   quantity_type load(
+      std::memory_order order = std::memory_order_seq_cst
+   ) const {
+      return quantity_type::from_raw( value.load( order ) );
+   }
+
+   /// replace the value by q
+   void store(
+      const quantity_type & q,
+      std::memory_order order = std::memory_order_seq_cst
+   ){
+      value.store( q.raw(), order );
+   }
+
+   /// replace the value by q, return the previous value
+   quantity_type exchange(
+      const quantity_type & q,
+      std::memory_order order = std::memory_order_seq_cst
+   ){
+      return quantity_type::from_raw( value.exchange( q.raw(), order ) );
+   }
+
+   /// replace the value by desired if it is equal to expected,
+   /// otherwise update expected; may fail spuriously
+   bool compare_exchange_weak(
+      quantity_type & expected, const quantity_type & desired,
+      std::memory_order order = std::memory_order_seq_cst
+   ){
+      V old = expected.raw();
+      const bool done = value.compare_exchange_weak( old, desired.raw(), order );
+      expected = quantity_type::from_raw( old );
+      return done;
+   }
+
+   /// replace the value by desired if it is equal to expected,
+   /// otherwise update expected
+   bool compare_exchange_strong(
+      quantity_type & expected, const quantity_type & desired,
+      std::memory_order order = std::memory_order_seq_cst
+   ){
+      V old = expected.raw();
+      const bool done = value.compare_exchange_strong( old, desired.raw(), order );
+      expected = quantity_type::from_raw( old );
+      return done;
+   }
+
+   /// add q, return the previous value
+   template< typename U >
+   ///@cond INTERNAL
+   requires type_multiset::equal< T, U >::value
+   ///@endcond
+   quantity_type fetch_add(
+      const quantity_implementation< V, U > & q,
+      std::memory_order order = std::memory_order_seq_cst
+   ){
+      if constexpr ( std::is_integral< V >::value ){
+         return quantity_type::from_raw( value.fetch_add( q.raw(), order ) );
+      } else {
+         V old = value.load( std::memory_order_relaxed );
+         while( ! value.compare_exchange_weak(
+            old, old + q.raw(), order, std::memory_order_relaxed
+         )){}
+         return quantity_type::from_raw( old );
+      }
+   }
+
+   /// subtract q, return the previous value
+   template< typename U >
+   ///@cond INTERNAL
+   requires type_multiset::equal< T, U >::value
+   ///@endcond
+   quantity_type fetch_sub(
+      const quantity_implementation< V, U > & q,
+      std::memory_order order = std::memory_order_seq_cst
+   ){
+      if constexpr ( std::is_integral< V >::value ){
+         return quantity_type::from_raw( value.fetch_sub( q.raw(), order ) );
+      } else {
+         V old = value.load( std::memory_order_relaxed );
+         while( ! value.compare_exchange_weak(
+            old, old - q.raw(), order, std::memory_order_relaxed
+         )){}
+         return quantity_type::from_raw( old );
+      }
+   }
+};
+
+#endif // ifndef quantity_atomic_hpp
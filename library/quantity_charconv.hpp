@@ -0,0 +1,253 @@
+// ==========================================================================
+//
+// quantity_charconv.hpp
+//
+// conversion of quantities to and from character sequences,
+// without locales, streams or heap allocation
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_charconv_hpp
+#define quantity_charconv_hpp
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <system_error>
+#include "quantity.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_charconv
+///
+/// to_chars( first, last, quantity ) writes a quantity
+/// as its base value followed by its tags.
+/// The value is written by std::to_chars, the tags by a single
+/// memcpy of the compile-time unit suffix type_multiset::name_v,
+/// which has the tags ordered by name, so the suffix of a
+/// quantity type doesn't depend on how its tag type was built.
+/// Like std::to_chars, it uses no locale and doesn't allocate.
+/// The result is a std::to_chars_result: ptr is the end of the
+/// written characters, or ec is std::errc::value_too_large
+/// (and ptr is last) when they don't fit.
+///
+/// from_chars( first, last, quantity ) reads a quantity in the form
+/// written by to_chars, or with its tags in another order or
+/// separated by spaces: the base value, read by std::from_chars,
+/// followed by the tags.
+/// Each tag is the (longest) name of an element of the tag type,
+/// optionally followed by its exponent (an int, which can be
+/// preceded by a '^'), and can be preceded by spaces or tabs.
+/// So for a kg m s-2 quantity "3.2kgms-2", "3.2 kg m s-2",
+/// "3.2 s^-2 m kg" and "3.2kg s-1 m s-1" are all accepted.
+/// The exponents of the tags are added per name, and the fingerprint
+/// of the result is compared to type_multiset::fingerprint of the tag
+/// type, so the order of the tags doesn't matter, and
+/// the output of type_multiset::print is accepted too.
+/// The tags must not be followed by a character that could continue
+/// them (a letter, digit, '_', '-' or '^').
+/// A suffix that is spelled as to_chars writes it is recognized
+/// with a single memcmp, other spellings are parsed tag by tag.
+/// The result is a std::from_chars_result.
+/// When it is successful, ptr points after the suffix.
+/// Otherwise quantity is not changed and ec is
+///    - std::errc::invalid_argument with ptr == first:
+///      there is no base value
+///    - std::errc::invalid_argument with ptr after the base value:
+///      the unit suffix doesn't match
+///    - std::errc::result_out_of_range (from std::from_chars):
+///      the base value doesn't fit its type
+//
+// ==========================================================================
+
+/// write a quantity as characters
+template< typename V, typename T >
+std::to_chars_result to_chars(
+   char * first, char * last,
+   const quantity_implementation< V, T > & q
+){
+   auto result = std::to_chars( first, last, q.raw() );
+   if( result.ec != std::errc() ){
+      return result;
+   }
+   constexpr auto length = sizeof( type_multiset::name_v< T > ) - 1;
+   if( std::size_t( last - result.ptr ) < length ){
+      return { last, std::errc::value_too_large };
+   }
+   std::memcpy( result.ptr, type_multiset::name_v< T >, length );
+   return { result.ptr + length, std::errc() };
+}
+
+///@cond INTERNAL
+namespace quantity_charconv {
+
+// whether c can be part of a unit suffix
+constexpr bool is_suffix_char( char c ){
+   return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' )
+      || ( c >= '0' && c <= '9' ) || c == '_' || c == '-' || c == '^';
+}
+
+// the length of the longest name of an element that the
+// characters in [ p, last ) start with, 0 when there is none
+template< typename Data, int Count, typename Tail >
+struct longest_name_recursor {
+   static std::size_t match( const char * p, const char * last ){
+      const std::size_t n = type_multiset::name_length( Data::name );
+      std::size_t i = 0;
+      while( i < n && p + i != last 
+         && p[ i ] == type_multiset::name_at( Data::name, i )
+      ){
+         ++i;
+      }
+      const auto rest = longest_name_recursor<
+         typename Tail::data, Tail::count, typename Tail::tail
+      >::match( p, last );
+      return i == n && n > rest ? n : rest;
+   }
+};
+
+template<>
+struct longest_name_recursor< void, 0, void > {
+   static std::size_t match( const char *, const char * ){
+      return 0;
+   }
+};
+
+// a tag of a unit suffix: its name, its exponent and its end,
+// ok is false when there is no tag
+struct tag {
+   bool ok;
+   const char * name;
+   const char * name_end;
+   int exponent;
+   const char * end;
+};
+
+// read the tag at p, after optional spaces or tabs:
+// the longest name of an element of List, and its exponent
+template< typename List >
+tag read_tag( const char * p, const char * last ){
+   while( p != last && ( *p == ' ' || *p == '\t' ) ){
+      ++p;
+   }
+   const auto n = longest_name_recursor<
+      typename List::data, List::count, typename List::tail
+   >::match( p, last );
+   if( n == 0 ){
+      return { false, p, p, 0, p };
+   }
+   tag t{ true, p, p + n, 1, p + n };
+   
+   // a bad exponent is left for the check that follows the suffix
+   auto e = t.name_end;
+   if( e != last && *e == '^' ){
+      ++e;
+   }
+   const auto result = std::from_chars( e, last, t.exponent );
+   if( result.ec == std::errc() ){
+      t.end = result.ptr;
+   } else {
+      t.exponent = 1;
+   }
+   return t;
+}
+
+inline bool same_name( const tag & a, const tag & b ){
+   return a.name_end - a.name == b.name_end - b.name
+      && std::memcmp( a.name, b.name, a.name_end - a.name ) == 0;
+}
+
+// the type_multiset::fingerprint of the tags of the unit suffix
+// at first, and (in end) the end of that suffix
+//
+// The exponents of a name are added at its first occurrence,
+// by reading the (short) suffix again, so nothing is stored.
+template< typename List >
+unsigned long long suffix_fingerprint( 
+   const char * first, const char * last, const char * & end
+){
+   unsigned long long sum = 0;
+   end = first;
+   for( auto t = read_tag< List >( first, last ); t.ok; 
+      t = read_tag< List >( t.end, last ) 
+   ){
+      end = t.end;
+      bool seen = false;
+      for( auto u = read_tag< List >( first, last ); u.name != t.name; 
+         u = read_tag< List >( u.end, last ) 
+      ){
+         seen = seen || same_name( u, t );
+      }
+      if( seen ){
+         continue;
+      }
+      long long exponent = 0;
+      for( auto u = t; u.ok; u = read_tag< List >( u.end, last ) ){
+         if( same_name( u, t ) ){
+            exponent += u.exponent;
+         }
+      }
+      if( exponent != 0 ){
+         sum += type_multiset::mix( 
+            type_multiset::name_hash( t.name, t.name_end )
+            ^ type_multiset::mix( (unsigned long long) exponent ) );
+      }
+   }
+   return type_multiset::mix( sum );
+}
+
+}; // namespace quantity_charconv
+///@endcond
+
+/// read a quantity from characters
+template< typename V, typename T >
+std::from_chars_result from_chars(
+   const char * first, const char * last,
+   quantity_implementation< V, T > & q
+){
+   V value;
+   auto result = std::from_chars( first, last, value );
+   if( result.ec != std::errc() ){
+      return result;
+   }
+   
+   // the usual spelling, as written by to_chars: the unit suffix,
+   // not followed by something that could be more of the suffix
+   // (after a space or tab more tags could follow)
+   constexpr auto length = sizeof( type_multiset::name_v< T > ) - 1;
+   if( std::size_t( last - result.ptr ) >= length
+      && std::memcmp( result.ptr, type_multiset::name_v< T >, length ) == 0
+   ){
+      const char * end = result.ptr + length;
+      if( end == last || ! ( quantity_charconv::is_suffix_char( *end ) 
+         || *end == ' ' || *end == '\t' ) 
+      ){
+         q = quantity_implementation< V, T >::from_raw( value );
+         return { end, std::errc() };
+      }
+   }
+   
+   // other spellings
+   const char * end;
+   const auto fingerprint = 
+      quantity_charconv::suffix_fingerprint< T >( result.ptr, last, end );
+   if( fingerprint != type_multiset::fingerprint< T >::value
+      || ( end != last && quantity_charconv::is_suffix_char( *end ) )
+   ){
+      return { result.ptr, std::errc::invalid_argument };
+   }
+   q = quantity_implementation< V, T >::from_raw( value );
+   return { end, std::errc() };
+}
+
+#endif // ifndef quantity_charconv_hpp
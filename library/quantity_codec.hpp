@@ -0,0 +1,370 @@
+// ==========================================================================
+//
+// quantity_codec.hpp
+//
+// compression of series of integer quantities:
+// delta, zigzag and frame-of-reference bit-packing in blocks
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_codec_hpp
+#define quantity_codec_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_codec
+///
+/// The quantity codec compresses a series of quantities with an
+/// integer base type, for instance a counter or a temperature in mK
+/// that changes slowly.
+/// It lives in the namespace quantity_codec.
+///
+/// The series is split in blocks of (at most) 128 values.
+/// In a block, each value is replaced by its difference with
+/// the previous value (delta), the differences are mapped to
+/// unsigned values with the small ones (positive or negative)
+/// first (zigzag), the smallest of those is subtracted from
+/// all of them (frame of reference), and the results are stored
+/// in the number of bits needed for the largest one.
+/// A counter that increases by the same amount every sample thus
+/// needs no bits at all, only the block header.
+///
+/// Each block starts with a header that holds the fingerprint of
+/// the tag type (type_multiset::fingerprint), the first value,
+/// the frame of reference, the number of values and the number of bits.
+/// The decoder checks the fingerprint of each block against the
+/// tag type it decodes into.
+/// The header and the bits are stored in the byte order of the host.
+///
+/// The available functionality is:
+///
+/// quantity_codec::encoder< V, T >
+///    write( quantity ) or write( span ) appends values,
+///    flush() writes the last (partial) block,
+///    data() is the encoded bytes
+///
+/// quantity_codec::decoder< V, T >( data, size )
+///    read( span ) decodes values into the span and returns
+///    the number of values it decoded,
+///    status() reports why decoding stopped
+//
+// ==========================================================================
+
+namespace quantity_codec {
+
+/// the (maximum) number of values in a block
+constexpr std::size_t block_size = 128;
+
+/// the size of a block header in bytes
+constexpr std::size_t header_size = 8 + 8 + 8 + 1 + 1;
+
+/// the state of a decoder
+enum class error {
+   none,             ///< no error (yet)
+   end,              ///< all blocks have been decoded
+   wrong_dimension,  ///< a block holds values of another tag type
+   truncated,        ///< the data ends within a block, or is corrupt
+};
+
+///@cond INTERNAL
+
+// the number of bits needed for x
+inline unsigned int bit_width( std::uint64_t x ){
+   return x == 0 ? 0 : 64 - __builtin_clzll( x );
+}
+
+// the number of 64-bit words for n values of bits bits
+inline std::size_t words_for( std::size_t n, unsigned int bits ){
+   return ( n * bits + 63 ) / 64;
+}
+
+template< typename V >
+std::uint64_t to_bits( V v ){
+   return std::is_signed< V >::value
+      ? std::uint64_t( std::int64_t( v ) )
+      : std::uint64_t( v );
+}
+
+inline std::uint64_t zigzag( std::uint64_t d ){
+   return ( d << 1 ) ^ std::uint64_t( std::int64_t( d ) >> 63 );
+}
+
+inline std::uint64_t unzigzag( std::uint64_t z ){
+   return ( z >> 1 ) ^ ( ~( z & 1 ) + 1 );
+}
+
+// pack n values (each < 2^bits) into words, which must be zero
+inline void pack(
+   const std::uint64_t * values, std::size_t n,
+   unsigned int bits, std::uint64_t * words
+){
+   if( bits == 0 ){
+      return;
+   }
+   for( std::size_t i = 0; i < n; ++i ){
+      const auto bit   = i * bits;
+      const auto k     = bit / 64;
+      const auto shift = bit % 64;
+      words[ k ] |= values[ i ] << shift;
+      if( shift + bits > 64 ){
+         words[ k + 1 ] |= values[ i ] >> ( 64 - shift );
+      }
+   }
+}
+
+// unpack n values of bits bits from words
+inline void unpack(
+   const std::uint64_t * words, std::size_t n,
+   unsigned int bits, std::uint64_t * values
+){
+   if( bits == 0 ){
+      for( std::size_t i = 0; i < n; ++i ){
+         values[ i ] = 0;
+      }
+      return;
+   }
+   const std::uint64_t mask = bits == 64 ? ~std::uint64_t( 0 )
+      : ( std::uint64_t( 1 ) << bits ) - 1;
+   for( std::size_t i = 0; i < n; ++i ){
+      const auto bit   = i * bits;
+      const auto k     = bit / 64;
+      const auto shift = bit % 64;
+      auto x = words[ k ] >> shift;
+      if( shift + bits > 64 ){
+         x |= words[ k + 1 ] << ( 64 - shift );
+      }
+      values[ i ] = x & mask;
+   }
+}
+
+///@endcond
+
+
+// ==========================================================================
+//
+// encoder
+//
+// ==========================================================================
+
+/// compresses a series of quantity_implementation< V, T > values
+template< typename V, typename T >
+class encoder {
+public:
+
+   static_assert( std::is_integral< V >::value && sizeof( V ) <= 8,
+      "the codec requires an integer base type of at most 64 bits" );
+
+   /// the quantity type of the values
+   using quantity_type = quantity_implementation< V, T >;
+
+private:
+
+   std::vector< unsigned char > bytes;
+   std::uint64_t pending[ block_size ];
+   std::size_t n = 0;
+
+   template< typename X >
+   void put( const X & x ){
+      const auto size = bytes.size();
+      bytes.resize( size + sizeof( X ) );
+      std::memcpy( bytes.data() + size, & x, sizeof( X ) );
+   }
+
+   void encode_block(){
+      std::uint64_t z[ block_size ];
+      std::uint64_t previous = pending[ 0 ];
+      z[ 0 ] = 0;
+      for( std::size_t i = 1; i < n; ++i ){
+         z[ i ] = zigzag( pending[ i ] - previous );
+         previous = pending[ i ];
+      }
+
+      std::uint64_t reference = n > 1 ? z[ 1 ] : 0;
+      std::uint64_t largest   = reference;
+      for( std::size_t i = 1; i < n; ++i ){
+         reference = z[ i ] < reference ? z[ i ] : reference;
+         largest   = z[ i ] > largest   ? z[ i ] : largest;
+      }
+      for( std::size_t i = 1; i < n; ++i ){
+         z[ i ] -= reference;
+      }
+      const auto bits = bit_width( largest - reference );
+
+      put( std::uint64_t( type_multiset::fingerprint< T >::value ) );
+      put( pending[ 0 ] );
+      put( reference );
+      put( std::uint8_t( n ) );
+      put( std::uint8_t( bits ) );
+
+      std::uint64_t words[ block_size ] = {};
+      pack( z + 1, n - 1, bits, words );
+      const auto size = bytes.size();
+      const auto count = words_for( n - 1, bits );
+      bytes.resize( size + count * sizeof( std::uint64_t ) );
+      std::memcpy( bytes.data() + size, words, count * sizeof( std::uint64_t ) );
+
+      n = 0;
+   }
+
+public:
+
+   /// append a value
+   void write( const quantity_type & q ){
+      pending[ n++ ] = to_bits( q.raw() );
+      if( n == block_size ){
+         encode_block();
+      }
+   }
+
+   /// append the values in a span
+   void write( quantity_span< const quantity_type > values ){
+      for( const auto & q : values ){
+         write( q );
+      }
+   }
+
+   /// write the values that don't fill a complete block
+   void flush(){
+      if( n > 0 ){
+         encode_block();
+      }
+   }
+
+   /// the encoded bytes (call flush() first to include all values)
+   const std::vector< unsigned char > & data() const {
+      return bytes;
+   }
+
+   /// remove the encoded bytes, for instance after they have been stored
+   void clear(){
+      bytes.clear();
+   }
+};
+
+
+// ==========================================================================
+//
+// decoder
+//
+// ==========================================================================
+
+/// decompresses a series of quantity_implementation< V, T > values
+template< typename V, typename T >
+class decoder {
+public:
+
+   static_assert( std::is_integral< V >::value && sizeof( V ) <= 8,
+      "the codec requires an integer base type of at most 64 bits" );
+
+   /// the quantity type of the values
+   using quantity_type = quantity_implementation< V, T >;
+
+private:
+
+   const unsigned char * next;
+   const unsigned char * last;
+   error state = error::none;
+
+   std::uint64_t values[ block_size ];
+   std::size_t available = 0;
+   std::size_t used = 0;
+
+   template< typename X >
+   X get(){
+      X x;
+      std::memcpy( & x, next, sizeof( X ) );
+      next += sizeof( X );
+      return x;
+   }
+
+   bool decode_block(){
+      if( next == last ){
+         state = error::end;
+         return false;
+      }
+      if( std::size_t( last - next ) < header_size ){
+         state = error::truncated;
+         return false;
+      }
+      if( get< std::uint64_t >() != type_multiset::fingerprint< T >::value ){
+         state = error::wrong_dimension;
+         return false;
+      }
+      const auto first     = get< std::uint64_t >();
+      const auto reference = get< std::uint64_t >();
+      const std::size_t n  = get< std::uint8_t >();
+      const unsigned bits  = get< std::uint8_t >();
+      if( n == 0 || n > block_size || bits > 64 ){
+         state = error::truncated;
+         return false;
+      }
+      const auto count = words_for( n - 1, bits );
+      if( std::size_t( last - next ) < count * sizeof( std::uint64_t ) ){
+         state = error::truncated;
+         return false;
+      }
+
+      std::uint64_t words[ block_size ];
+      std::memcpy( words, next, count * sizeof( std::uint64_t ) );
+      next += count * sizeof( std::uint64_t );
+      unpack( words, n - 1, bits, values + 1 );
+
+      values[ 0 ] = first;
+      for( std::size_t i = 1; i < n; ++i ){
+         values[ i ] = values[ i - 1 ] + unzigzag( values[ i ] + reference );
+      }
+      available = n;
+      used = 0;
+      return true;
+   }
+
+public:
+
+   /// create a decoder for size bytes of encoded data
+   decoder( const unsigned char * data, std::size_t size ):
+      next( data ), last( data + size )
+   {}
+
+   /// decode values into out, return the number of values decoded
+   //
+   /// When this is less than out.size(), error() tells why.
+   std::size_t read( quantity_span< quantity_type > out ){
+      std::size_t done = 0;
+      while( done < out.size() ){
+         if( used == available && ! decode_block() ){
+            break;
+         }
+         while( used < available && done < out.size() ){
+            out[ done++ ] = quantity_type::from_raw( V( values[ used++ ] ) );
+         }
+      }
+      return done;
+   }
+
+   /// why read() returned less values than requested
+   error status() const {
+      return state;
+   }
+};
+
+}; // namespace quantity_codec
+
+#endif // ifndef quantity_codec_hpp
@@ -0,0 +1,300 @@
+// ==========================================================================
+//
+// quantity_counting.hpp
+//
+// opt-in counting of the quantity operations, per operation and dimension
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_counting_hpp
+#define quantity_counting_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+#include "type_multiset.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_counting
+///
+/// Operation counting finds the hot spots in code that uses quantities.
+/// It is enabled by defining QUANTITY_COUNT_OPERATIONS before
+/// quantity.hpp is included (preferably on the command line,
+/// for all translation units).
+/// Without it, quantity.hpp doesn't include this file, and the
+/// quantity operators are exactly what they are without counting.
+///
+/// With counting enabled, each quantity operator that runs
+/// (not in a constant evaluation) increments a counter for its
+/// operation and the tags of its operands, for instance the
+/// division of a J (kg m2 s-2) quantity by an s quantity.
+/// The counters are thread-local, a thread adds its counts to the
+/// totals when it ends, or when it calls merge().
+/// It lives in the namespace quantity_counting.
+///
+/// totals() returns the counts of all (operation, tags) combinations
+/// that ran, report( file ) writes them as text, most frequent first,
+/// one "count  left operation right" line per combination,
+/// and report_at_exit( path ) writes that report when the program ends.
+/// The tags are written as type_multiset::name_v, a plain value as 1,
+/// so these tags must have compile-time names.
+//
+// ==========================================================================
+
+namespace quantity_counting {
+
+/// the counted operations
+enum class operation {
+   plus,             ///< + q
+   add,              ///< q + q
+   add_assign,       ///< q += q
+   minus,            ///< - q
+   subtract,         ///< q - q
+   subtract_assign,  ///< q -= q
+   multiply,         ///< q * q, q * value, value * q
+   divide,           ///< q / q, q / value, value / q
+   compare,          ///< q == q, q != q, q < q, q <= q, q > q, q >= q
+};
+
+/// the symbol of an operation, as the report writes it
+inline const char * symbol( operation op ){
+   switch( op ){
+      case operation::plus:             return "+";
+      case operation::add:              return "+";
+      case operation::add_assign:       return "+=";
+      case operation::minus:            return "-";
+      case operation::subtract:         return "-";
+      case operation::subtract_assign:  return "-=";
+      case operation::multiply:         return "*";
+      case operation::divide:           return "/";
+      default:                          return "<=>";
+   }
+}
+
+/// the count of one operation on the tags of its operands
+struct entry {
+
+   /// the operation
+   operation op;
+
+   /// the name of the tags of the left (or only) operand
+   const char * left;
+
+   /// the name of the tags of the right operand, "" for unary operations
+   const char * right;
+
+   /// the number of times the operation ran
+   std::uint64_t count;
+};
+
+///@cond INTERNAL
+
+// the (operation, tags) combinations and their merged counts
+struct registry {
+   std::mutex lock;
+   std::vector< entry > entries;
+};
+
+inline registry & shared(){
+   static registry r;
+   return r;
+}
+
+// the number of a new (operation, tags) combination
+inline std::size_t enroll( operation op, const char * left, const char * right ){
+   auto & r = shared();
+   std::lock_guard< std::mutex > guard( r.lock );
+   r.entries.push_back( entry{ op, left, right, 0 } );
+   return r.entries.size() - 1;
+}
+
+// whether the counts of this thread have been merged for the last time,
+// trivially destructible, so it can still be read after that
+// (for instance by the report_at_exit handler)
+inline bool & local_ended(){
+   thread_local bool ended = false;
+   return ended;
+}
+
+// the counts of one thread, added to the totals when it ends
+struct local_counts {
+   std::vector< std::uint64_t > counts;
+
+   void merge(){
+      auto & r = shared();
+      std::lock_guard< std::mutex > guard( r.lock );
+      for( std::size_t i = 0; i < counts.size(); ++i ){
+         r.entries[ i ].count += counts[ i ];
+         counts[ i ] = 0;
+      }
+   }
+
+   ~local_counts(){
+      merge();
+      local_ended() = true;
+   }
+};
+
+inline local_counts & local(){
+   thread_local local_counts c;
+   return c;
+}
+
+// the name of the tags R, "" for a unary operation (R is void)
+template< typename R >
+struct tags_name {
+   static constexpr const char * value = type_multiset::name_v< R >;
+};
+
+template<>
+struct tags_name< void > {
+   static constexpr const char * value = "";
+};
+
+// the number of the combination ( Op, L, R ), assigned on first use
+template< operation Op, typename L, typename R >
+std::size_t number(){
+   static const std::size_t n =
+      enroll( Op, tags_name< L >::value, tags_name< R >::value );
+   return n;
+}
+
+///@endcond
+
+/// count one operation Op on operands with tags L and R
+//
+/// R is void for a unary operation, and type_multiset::empty
+/// for a plain value.
+/// The quantity operators call this, when counting is enabled.
+template< operation Op, typename L, typename R >
+void count(){
+   if( local_ended() ){
+      return;
+   }
+   const auto n = number< Op, L, R >();
+   auto & c = local().counts;
+   if( c.size() <= n ){
+      c.resize( n + 1, 0 );
+   }
+   ++c[ n ];
+}
+
+/// add the counts of the calling thread to the totals
+inline void merge(){
+   if( ! local_ended() ){
+      local().merge();
+   }
+}
+
+///@cond INTERNAL
+
+// the merged counts, without merging those of the calling thread,
+// with the combinations of equal multisets combined
+inline std::vector< entry > merged_totals(){
+   std::vector< entry > result;
+   auto & r = shared();
+   std::lock_guard< std::mutex > guard( r.lock );
+   for( const auto & e : r.entries ){
+      if( e.count == 0 ){
+         continue;
+      }
+
+      // equal multisets share their name_v array
+      auto same = std::find_if( result.begin(), result.end(),
+         [ & ]( const entry & x ){
+            return x.op == e.op && x.left == e.left && x.right == e.right;
+         } );
+      if( same == result.end() ){
+         result.push_back( e );
+      } else {
+         same->count += e.count;
+      }
+   }
+   return result;
+}
+
+// write the counts to file, most frequent first
+inline void write_report( std::FILE * file, std::vector< entry > all ){
+   std::stable_sort( all.begin(), all.end(),
+      []( const entry & a, const entry & b ){ return a.count > b.count; } );
+   const auto name = []( const char * s ){ return *s == '\0' ? "1" : s; };
+   for( const auto & e : all ){
+      if( e.op == operation::plus || e.op == operation::minus ){
+         std::fprintf( file, "%12llu  %s %s\n",
+            (unsigned long long) e.count, symbol( e.op ), name( e.left ) );
+      } else {
+         std::fprintf( file, "%12llu  %s %s %s\n",
+            (unsigned long long) e.count,
+            name( e.left ), symbol( e.op ), name( e.right ) );
+      }
+   }
+}
+
+///@endcond
+
+/// the counts of all (operation, tags) combinations that ran
+//
+/// This merges the counts of the calling thread first.
+/// The counts of other threads that still run are included
+/// up to their last merge().
+/// Combinations of equal multisets (for instance add< a, b >
+/// and add< b, a >) are combined into one entry.
+inline std::vector< entry > totals(){
+   merge();
+   return merged_totals();
+}
+
+/// write the totals to file, most frequent first
+inline void report( std::FILE * file = stderr ){
+   write_report( file, totals() );
+}
+
+///@cond INTERNAL
+inline const char * & exit_report_path(){
+   static const char * path = nullptr;
+   return path;
+}
+///@endcond
+
+/// write the report to path (stderr when nullptr) when the program ends
+//
+/// path must remain valid (a string literal).
+/// The counts of threads that still run at that moment are not included.
+/// Operations that run after the main thread has merged its counts
+/// for the last time (in destructors of static objects) are not counted.
+inline void report_at_exit( const char * path = nullptr ){
+   shared();
+   exit_report_path() = path;
+
+   // the counts of the main thread are merged by the destructor of its
+   // (thread_local) counts, which has run when this handler runs
+   std::atexit( [](){
+      const char * path = exit_report_path();
+      std::FILE * file = path == nullptr ? stderr : std::fopen( path, "w" );
+      if( file != nullptr ){
+         write_report( file, merged_totals() );
+         if( file != stderr ){
+            std::fclose( file );
+         }
+      }
+   } );
+}
+
+}; // namespace quantity_counting
+
+#endif // ifndef quantity_counting_hpp
@@ -0,0 +1,328 @@
+// ==========================================================================
+//
+// quantity_csv.hpp
+//
+// reading CSV files into tables of quantities
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_csv_hpp
+#define quantity_csv_hpp
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+#include "quantity_table.hpp"
+#include "quantity_parallel.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_csv
+///
+/// quantity_csv::read( policy, path, table ) reads a CSV file
+/// into a quantity_table, one column of the file per column
+/// of the table.
+/// It lives in the namespace quantity_csv.
+///
+/// The first line of the file is the header.
+/// It must have one field per column of the table, and each field
+/// is a name, optionally followed by the unit of the column in
+/// square brackets: time[s], force[kgms-2].
+/// The unit must be the suffix of the tag type of the column
+/// (type_multiset::name_v); a field without a unit is a column
+/// without tags.
+/// The names are not checked.
+///
+/// Each further line that isn't empty is a row of the table:
+/// the base values of the fields, separated by commas,
+/// without units.
+/// Spaces around values, and lines that end in a carriage return
+/// and a newline, are allowed.
+///
+/// The file is mapped into memory (POSIX mmap).
+/// Under a parallel execution policy it is split into chunks of
+/// whole lines, which are parsed by the threads of the
+/// quantity_parallel pool: one pass counts the rows of each chunk,
+/// the second parses the values (std::from_chars) directly into
+/// the columns of the table.
+///
+/// The result is error::none, or the first error that was found;
+/// after an error the contents of the table are unspecified.
+///
+/// parse( policy, data, size, table ) does the same for CSV text
+/// that is already in memory.
+//
+// ==========================================================================
+
+namespace quantity_csv {
+
+/// the result of reading a CSV file
+enum class error {
+   none,          ///< the file was read
+   cannot_open,   ///< the file can't be opened or mapped
+   wrong_columns, ///< the header or a row has the wrong number of fields
+   wrong_unit,    ///< the unit of a header field is not that of its column
+   bad_value,     ///< a field is not a valid base value
+};
+
+///@cond INTERNAL
+
+inline const char * skip_spaces( const char * p, const char * end ){
+   while( p != end && *p == ' ' ){
+      ++p;
+   }
+   return p;
+}
+
+// the end of the line that starts at p, without the \r
+inline const char * line_end( const char * p, const char * end ){
+   auto e = static_cast< const char * >( std::memchr( p, '\n', end - p ) );
+   if( e == nullptr ){
+      e = end;
+   }
+   if( e != p && e[ -1 ] == '\r' ){
+      --e;
+   }
+   return e;
+}
+
+// the start of the line after p
+inline const char * next_line( const char * p, const char * end ){
+   auto e = static_cast< const char * >( std::memchr( p, '\n', end - p ) );
+   return e == nullptr ? end : e + 1;
+}
+
+// the first line start at or after p
+inline const char * line_start(
+   const char * begin, const char * p, const char * end
+){
+   return p == begin ? p : next_line( p - 1, end );
+}
+
+// call f( first, last ) for each non-empty line that starts
+// in [ p, chunk_end ), stop when it returns false
+template< typename F >
+bool for_each_line(
+   const char * p, const char * chunk_end, const char * end, F f
+){
+   while( p < chunk_end ){
+      const auto e = line_end( p, end );
+      if( e != p && ! f( p, e ) ){
+         return false;
+      }
+      p = next_line( p, end );
+   }
+   return true;
+}
+
+// check the unit of header field [ p, e ) against tag type T
+template< typename T >
+bool unit_matches( const char * p, const char * e ){
+   while( e != p && e[ -1 ] == ' ' ){
+      --e;
+   }
+   const char * unit = e;
+   if( e != p && e[ -1 ] == ']' ){
+      unit = static_cast< const char * >( std::memchr( p, '[', e - p ) );
+      if( unit == nullptr ){
+         return false;
+      }
+      ++unit;
+      --e;
+   }
+   const std::size_t length = sizeof( type_multiset::name_v< T > ) - 1;
+   return std::size_t( e - unit ) == length
+      && std::memcmp( unit, type_multiset::name_v< T >, length ) == 0;
+}
+
+// check the header line [ p, e ) against the columns of Table
+template< typename Table, std::size_t... I >
+error check_header(
+   const char * p, const char * e, std::index_sequence< I... >
+){
+   std::size_t fields = 1;
+   for( auto q = p; q != e; ++q ){
+      fields += *q == ',';
+   }
+   if( fields != Table::columns ){
+      return error::wrong_columns;
+   }
+   bool match = true;
+   ( ( match = match && [ & ](){
+      const auto comma = static_cast< const char * >(
+         std::memchr( p, ',', e - p ) );
+      const auto field_end = comma == nullptr ? e : comma;
+      const bool ok = unit_matches<
+         typename Table::template column_type< I >::tags >( p, field_end );
+      p = comma == nullptr ? e : comma + 1;
+      return ok;
+   }() ), ... );
+   return match ? error::none : error::wrong_unit;
+}
+
+// parse one field into column I of row i
+template< typename Table, std::size_t I >
+error parse_field(
+   const char * & p, const char * e, Table & table, std::size_t i
+){
+   using Q = typename Table::template column_type< I >;
+   p = skip_spaces( p, e );
+   typename Q::value_type value;
+   const auto result = std::from_chars( p, e, value );
+   if( result.ec != std::errc() ){
+      return error::bad_value;
+   }
+   table.template column< I >().raw()[ i ] = value;
+   p = skip_spaces( result.ptr, e );
+   if( I + 1 < Table::columns ){
+      if( p == e ){
+         return error::wrong_columns;
+      }
+      if( *p != ',' ){
+         return error::bad_value;
+      }
+      ++p;
+   } else if( p != e ){
+      return *p == ',' ? error::wrong_columns : error::bad_value;
+   }
+   return error::none;
+}
+
+// parse the line [ p, e ) into row i
+template< typename Table, std::size_t... I >
+error parse_row(
+   const char * p, const char * e, Table & table, std::size_t i,
+   std::index_sequence< I... >
+){
+   auto result = error::none;
+   ( ( result = result == error::none
+      ? parse_field< Table, I >( p, e, table, i )
+      : result ), ... );
+   return result;
+}
+
+///@endcond
+
+/// parse CSV text into a table
+template< typename P, typename... Columns >
+///@cond INTERNAL
+requires quantity_parallel::execution_policy< P >
+///@endcond
+error parse(
+   P && policy, const char * data, std::size_t size,
+   quantity_table< Columns... > & table
+){
+   using table_type = quantity_table< Columns... >;
+   const auto columns = std::index_sequence_for< Columns... >();
+   const char * end = data + size;
+
+   const auto header_end = line_end( data, end );
+   auto result = check_header< table_type >( data, header_end, columns );
+   if( result != error::none ){
+      return result;
+   }
+
+   const char * body = next_line( data, end );
+   const std::size_t n = end - body;
+   const auto count = quantity_parallel::chunks( policy, n );
+   auto chunk = [ & ]( std::size_t c ){
+      return line_start( body,
+         body + quantity_parallel::chunk_begin( c, count, n ), end );
+   };
+
+   // count the rows in each chunk, and number them
+   std::vector< std::size_t > first( count + 1, 0 );
+   quantity_parallel::for_chunks( n, count,
+      [ & ]( std::size_t c, std::size_t, std::size_t ){
+         std::size_t rows = 0;
+         for_each_line( chunk( c ), chunk( c + 1 ), end,
+            [ & ]( const char *, const char * ){
+               ++rows;
+               return true;
+            } );
+         first[ c + 1 ] = rows;
+      } );
+   for( std::size_t c = 0; c < count; ++c ){
+      first[ c + 1 ] += first[ c ];
+   }
+   table.resize( first[ count ] );
+
+   // parse the rows
+   std::vector< error > errors( count, error::none );
+   quantity_parallel::for_chunks( n, count,
+      [ & ]( std::size_t c, std::size_t, std::size_t ){
+         auto i = first[ c ];
+         for_each_line( chunk( c ), chunk( c + 1 ), end,
+            [ & ]( const char * p, const char * e ){
+               errors[ c ] = parse_row( p, e, table, i++, columns );
+               return errors[ c ] == error::none;
+            } );
+      } );
+   for( const auto e : errors ){
+      if( e != error::none ){
+         return e;
+      }
+   }
+   return error::none;
+}
+
+/// read a CSV file into a table
+template< typename P, typename... Columns >
+///@cond INTERNAL
+requires quantity_parallel::execution_policy< P >
+///@endcond
+error read(
+   P && policy, const char * path, quantity_table< Columns... > & table
+){
+   const int fd = ::open( path, O_RDONLY );
+   if( fd < 0 ){
+      return error::cannot_open;
+   }
+   struct stat s;
+   if( ::fstat( fd, & s ) != 0 ){
+      ::close( fd );
+      return error::cannot_open;
+   }
+   const std::size_t length = s.st_size;
+   if( length == 0 ){
+      ::close( fd );
+      return parse( policy, "", 0, table );
+   }
+   const auto base = ::mmap( nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+   ::close( fd );
+   if( base == MAP_FAILED ){
+      return error::cannot_open;
+   }
+   const auto result = parse(
+      policy, static_cast< const char * >( base ), length, table );
+   ::munmap( base, length );
+   return result;
+}
+
+/// read a CSV file into a table, in the calling thread
+template< typename... Columns >
+error read( const char * path, quantity_table< Columns... > & table ){
+   return read( quantity_parallel::seq, path, table );
+}
+
+}; // namespace quantity_csv
+
+#endif // ifndef quantity_csv_hpp
@@ -0,0 +1,324 @@
+// ==========================================================================
+//
+// quantity_export.hpp
+//
+// bulk export of spans and tables of quantities as CSV or JSON
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_export_hpp
+#define quantity_export_hpp
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+#include "quantity_table.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_export
+///
+/// The export functions write spans and tables of quantities
+/// to a quantity_export::writer, as CSV or as JSON.
+/// They live in the namespace quantity_export.
+///
+/// The unit of a column (type_multiset::name_v of its tag type)
+/// is written once, in the header or schema,
+/// the values are written as plain base values (std::to_chars).
+///
+/// csv( writer, names, table ), csv( writer, name, span )
+///    a header line of name[unit] fields, followed by one line
+///    per row, as read by quantity_csv::read
+///
+/// json( writer, names, table ), json( writer, name, span )
+///    {"columns":[{"name":"time","unit":"s"},...],
+///    "rows":[[0,1.5],...]}
+///    A value that is not finite is written as null.
+///
+/// A writer collects the characters in a buffer of a fixed size,
+/// which is reused: it is written to the file with one write()
+/// call each time it is (nearly) full.
+/// The names are written as-is, so they should not contain
+/// characters that must be quoted.
+//
+// ==========================================================================
+
+namespace quantity_export {
+
+/// the state of a writer
+enum class error {
+   none,          ///< no error (yet)
+   cannot_open,   ///< the file can't be opened or created
+   cannot_write,  ///< writing to the file failed
+};
+
+/// the maximum number of characters of one base value
+constexpr std::size_t max_value_size = 32;
+
+/// buffered output to a file
+class writer {
+private:
+
+   std::vector< char > buffer;
+   std::size_t used = 0;
+   int fd = -1;
+   error state = error::none;
+
+public:
+
+   /// create a writer that writes in blocks of (at most) size bytes
+   explicit writer( std::size_t size = 1 << 20 ):
+      buffer( size < 4 * max_value_size ? 4 * max_value_size : size )
+   {}
+
+   writer( const writer & ) = delete;
+   writer & operator=( const writer & ) = delete;
+
+   ~writer(){
+      close();
+   }
+
+   /// create (or truncate) a file, close the current one
+   error open( const char * path ){
+      close();
+      fd = ::open( path, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      state = fd < 0 ? error::cannot_open : error::none;
+      return state;
+   }
+
+   /// write the buffered characters to the file
+   void flush(){
+      const char * p = buffer.data();
+      while( state == error::none && used > 0 ){
+         const auto n = ::write( fd, p, used );
+         if( n <= 0 ){
+            state = error::cannot_write;
+         } else {
+            p += n;
+            used -= n;
+         }
+      }
+      used = 0;
+   }
+
+   /// flush and close the file, return the state
+   error close(){
+      if( fd >= 0 ){
+         flush();
+         ::close( fd );
+         fd = -1;
+      }
+      return state;
+   }
+
+   /// the state of the writer
+   error status() const {
+      return state;
+   }
+
+   /// make room for (at least) n characters
+   void reserve( std::size_t n ){
+      if( buffer.size() - used < n ){
+         flush();
+         if( buffer.size() < n ){
+            buffer.resize( n );
+         }
+      }
+   }
+
+   /// append characters
+   void put( const char * s, std::size_t n ){
+      while( n > 0 ){
+         reserve( 1 );
+         const auto part = std::min( n, buffer.size() - used );
+         std::memcpy( buffer.data() + used, s, part );
+         used += part;
+         s += part;
+         n -= part;
+      }
+   }
+
+   /// append a null-terminated string
+   void put( const char * s ){
+      put( s, std::strlen( s ) );
+   }
+
+   /// append a character
+   void put( char c ){
+      reserve( 1 );
+      buffer[ used++ ] = c;
+   }
+
+   /// append a base value, null for a JSON value that isn't finite
+   //
+   /// reserve( max_value_size ) must have been called.
+   template< typename V >
+   void put_value( V value, bool json = false ){
+      if( std::is_floating_point< V >::value && json
+         && ! std::isfinite( value )
+      ){
+         std::memcpy( buffer.data() + used, "null", 4 );
+         used += 4;
+         return;
+      }
+      char * const p = buffer.data() + used;
+      used += std::to_chars( p, p + max_value_size, value ).ptr - p;
+   }
+};
+
+///@cond INTERNAL
+
+template< typename T >
+void put_unit( writer & w ){
+   w.put( type_multiset::name_v< T >, sizeof( type_multiset::name_v< T > ) - 1 );
+}
+
+template< typename Table, std::size_t... I >
+void csv_header(
+   writer & w, const char * const * names, std::index_sequence< I... >
+){
+   ( ( w.put( I == 0 ? "" : "," ),
+      w.put( names[ I ] ),
+      w.put( '[' ),
+      put_unit< typename Table::template column_type< I >::tags >( w ),
+      w.put( ']' ) ), ... );
+   w.put( '\n' );
+}
+
+template< typename Table, std::size_t... I >
+void json_schema(
+   writer & w, const char * const * names, std::index_sequence< I... >
+){
+   w.put( "{\"columns\":[" );
+   ( ( w.put( I == 0 ? "{\"name\":\"" : ",{\"name\":\"" ),
+      w.put( names[ I ] ),
+      w.put( "\",\"unit\":\"" ),
+      put_unit< typename Table::template column_type< I >::tags >( w ),
+      w.put( "\"}" ) ), ... );
+   w.put( "],\n\"rows\":[" );
+}
+
+// write the rows: the fields separated by commas, each row between
+// begin and end, the rows separated by separator
+template< typename Table, std::size_t... I >
+void rows(
+   writer & w, const Table & table, bool json,
+   const char * begin, const char * end, const char * separator,
+   std::index_sequence< I... >
+){
+   const auto columns = std::make_tuple(
+      table.template column< I >().raw()... );
+   const std::size_t row_size = sizeof...( I ) * ( max_value_size + 1 )
+      + std::strlen( begin ) + std::strlen( end ) + std::strlen( separator );
+   for( std::size_t i = 0; i < table.size(); ++i ){
+      w.reserve( row_size );
+      w.put( i == 0 ? "" : separator );
+      w.put( begin );
+      ( ( w.put( I == 0 ? "" : "," ),
+         w.put_value( std::get< I >( columns )[ i ], json ) ), ... );
+      w.put( end );
+   }
+}
+
+// the table with one column of quantity type Q
+template< typename Q >
+using single_column = quantity_table< quantity_implementation<
+   typename Q::value_type, typename Q::tags > >;
+
+// write the values of a span, one per row
+template< typename Q >
+void span_rows(
+   writer & w, quantity_span< Q > values, bool json,
+   const char * begin, const char * end, const char * separator
+){
+   const std::size_t row_size = max_value_size
+      + std::strlen( begin ) + std::strlen( end ) + std::strlen( separator );
+   const auto raw = values.raw();
+   for( std::size_t i = 0; i < values.size(); ++i ){
+      w.reserve( row_size );
+      w.put( i == 0 ? "" : separator );
+      w.put( begin );
+      w.put_value( raw[ i ], json );
+      w.put( end );
+   }
+}
+
+///@endcond
+
+
+// ==========================================================================
+//
+// CSV
+//
+// ==========================================================================
+
+/// write a table as CSV, with one name per column
+template< typename... Columns >
+void csv(
+   writer & w, const char * const ( & names )[ sizeof...( Columns ) ],
+   const quantity_table< Columns... > & table
+){
+   using table_type = quantity_table< Columns... >;
+   csv_header< table_type >( w, names, std::index_sequence_for< Columns... >() );
+   rows( w, table, false, "", "\n", "",
+      std::index_sequence_for< Columns... >() );
+}
+
+/// write a span as CSV, with a single column
+template< typename Q >
+void csv( writer & w, const char * name, quantity_span< Q > values ){
+   csv_header< single_column< Q > >( w, & name, std::index_sequence< 0 >() );
+   span_rows( w, values, false, "", "\n", "" );
+}
+
+
+// ==========================================================================
+//
+// JSON
+//
+// ==========================================================================
+
+/// write a table as JSON, with one name per column
+template< typename... Columns >
+void json(
+   writer & w, const char * const ( & names )[ sizeof...( Columns ) ],
+   const quantity_table< Columns... > & table
+){
+   using table_type = quantity_table< Columns... >;
+   json_schema< table_type >( w, names, std::index_sequence_for< Columns... >() );
+   rows( w, table, true, "[", "]", ",\n",
+      std::index_sequence_for< Columns... >() );
+   w.put( "]}\n" );
+}
+
+/// write a span as JSON, with a single column
+template< typename Q >
+void json( writer & w, const char * name, quantity_span< Q > values ){
+   json_schema< single_column< Q > >( w, & name, std::index_sequence< 0 >() );
+   span_rows( w, values, true, "[", "]", ",\n" );
+   w.put( "]}\n" );
+}
+
+}; // namespace quantity_export
+
+#endif // ifndef quantity_export_hpp
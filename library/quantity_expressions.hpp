@@ -0,0 +1,378 @@
+// ==========================================================================
+//
+// quantity_expressions.hpp
+//
+// lazy, fused element-wise arithmetic on spans of quantities
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_expressions_hpp
+#define quantity_expressions_hpp
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+#include "quantity_parallel.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_expressions
+///
+/// An expression over spans of quantities, like a * b + c * d,
+/// normally creates a temporary array for each operator.
+/// The quantity expressions instead build an expression object
+/// that records the operations and the tag type of the result,
+/// and compute all elements in one loop when the expression is
+/// assigned.
+/// They live in the namespace quantity_expressions.
+///
+/// The available functionality is:
+///
+/// quantity_expressions::lazy( span )
+///    an expression for the elements of a span of quantities
+///
+/// quantity_expressions::lazy( quantity )
+///    an expression that has the value of the quantity for each element
+///
+/// +, -, *, /
+///    combine two expressions, or an expression and a plain value,
+///    into an expression.
+///    The tag type of the result is determined in the same way as for
+///    quantities: + and - require equal tag types,
+///    * adds the tag types, / subtracts them.
+///
+/// quantity_expressions::evaluate( out, expression )
+///    out[ i ] = element i of the expression, for all elements of out.
+///    The tag type of out must be equal to that of the expression.
+///    Large spans are split over the quantity_parallel thread pool.
+///    Returns false, without changing out, when a span used in the
+///    expression has fewer elements than out.
+///
+/// lazy( out ) = expression
+///    the same as evaluate( out, expression ),
+///    but a span that is too short is an assertion failure.
+///
+/// Spans used in an expression must have (at least) as many
+/// elements as the span the expression is assigned to.
+//
+// ==========================================================================
+
+namespace quantity_expressions {
+
+///@cond INTERNAL
+
+// ==========================================================================
+//
+// the expression nodes
+//
+// Each node has a value_type (the base type of its elements),
+// a tags type, an at( i ) that computes the base value of
+// element i, and a size() (the number of elements it has).
+//
+// ==========================================================================
+
+template< typename E >
+struct is_expression : std::false_type {};
+
+template< typename E >
+concept bool expression = is_expression< E >::value;
+
+// an operand is an expression or a plain (arithmetic) value
+template< typename X >
+concept bool operand = expression< X > || std::is_arithmetic< X >::value;
+
+// the elements of a span
+template< typename Q >
+class terminal {
+public:
+   using value_type = typename quantity_span< Q >::value_type;
+   using tags       = typename quantity_span< Q >::tags;
+
+private:
+   quantity_span< Q > span;
+
+public:
+   constexpr explicit terminal( quantity_span< Q > span ):
+      span( span )
+   {}
+
+   // the assignment below doesn't copy the terminal, copying does
+   constexpr terminal( const terminal & ) = default;
+
+   __attribute__((always_inline))
+   constexpr value_type at( std::size_t i ) const {
+      return span.raw()[ i ];
+   }
+
+   constexpr std::size_t size() const {
+      return span.size();
+   }
+
+   // evaluate an expression into the span
+   // (evaluate() is found by argument dependent lookup)
+   template< typename E >
+   requires expression< E >
+   const terminal & operator=( const E & e ) const {
+      const bool fits = evaluate( span, e );
+      assert( fits && "a span of the expression is too short" );
+      (void) fits;
+      return *this;
+   }
+
+   const terminal & operator=( const terminal & e ) const {
+      const bool fits = evaluate( span, e );
+      assert( fits && "a span of the expression is too short" );
+      (void) fits;
+      return *this;
+   }
+};
+
+template< typename Q >
+struct is_expression< terminal< Q > > : std::true_type {};
+
+// one value for all elements
+template< typename V, typename T >
+class scalar {
+public:
+   using value_type = V;
+   using tags       = T;
+
+private:
+   V value;
+
+public:
+   constexpr explicit scalar( const V & value ):
+      value( value )
+   {}
+
+   __attribute__((always_inline))
+   constexpr value_type at( std::size_t ) const {
+      return value;
+   }
+
+   // as many elements as needed
+   constexpr std::size_t size() const {
+      return std::numeric_limits< std::size_t >::max();
+   }
+};
+
+template< typename V, typename T >
+struct is_expression< scalar< V, T > > : std::true_type {};
+
+// the operators: the base operation and the resulting tags
+struct plus {
+   template< typename A, typename B >
+   __attribute__((always_inline))
+   static constexpr auto apply( const A & a, const B & b ){ return a + b; }
+
+   template< typename T, typename U >
+   using tags = T;
+};
+
+struct minus {
+   template< typename A, typename B >
+   __attribute__((always_inline))
+   static constexpr auto apply( const A & a, const B & b ){ return a - b; }
+
+   template< typename T, typename U >
+   using tags = T;
+};
+
+struct multiplies {
+   template< typename A, typename B >
+   __attribute__((always_inline))
+   static constexpr auto apply( const A & a, const B & b ){ return a * b; }
+
+   template< typename T, typename U >
+   using tags = type_multiset::add< T, U >;
+};
+
+struct divides {
+   template< typename A, typename B >
+   __attribute__((always_inline))
+   static constexpr auto apply( const A & a, const B & b ){ return a / b; }
+
+   template< typename T, typename U >
+   using tags = type_multiset::add< T, type_multiset::multiply< U, -1 > >;
+};
+
+// an operator applied to two expressions
+template< typename Op, typename L, typename R >
+class binary {
+public:
+   using value_type = decltype( Op::apply(
+      std::declval< typename L::value_type >(),
+      std::declval< typename R::value_type >() ) );
+   using tags = typename Op::template tags<
+      typename L::tags, typename R::tags >;
+
+private:
+   L left;
+   R right;
+
+public:
+   constexpr binary( const L & left, const R & right ):
+      left( left ), right( right )
+   {}
+
+   __attribute__((always_inline))
+   constexpr value_type at( std::size_t i ) const {
+      return Op::apply( left.at( i ), right.at( i ) );
+   }
+
+   constexpr std::size_t size() const {
+      return left.size() < right.size() ? left.size() : right.size();
+   }
+};
+
+template< typename Op, typename L, typename R >
+struct is_expression< binary< Op, L, R > > : std::true_type {};
+
+// an operand as expression: a plain value becomes a scalar without tags
+template< typename E >
+requires expression< E >
+constexpr const E & as_expression( const E & e ){
+   return e;
+}
+
+template< typename X >
+requires std::is_arithmetic< X >::value
+constexpr auto as_expression( const X & x ){
+   return scalar< X, type_multiset::empty >( x );
+}
+
+template< typename X >
+using expression_of = typename std::decay<
+   decltype( as_expression( std::declval< X >() ) ) >::type;
+
+template< typename Op, typename L, typename R >
+constexpr auto make_binary( const L & left, const R & right ){
+   return binary< Op, expression_of< L >, expression_of< R > >(
+      as_expression( left ), as_expression( right ) );
+}
+
+template< typename L, typename R >
+concept bool same_tags = type_multiset::equal<
+   typename expression_of< L >::tags,
+   typename expression_of< R >::tags
+>::value;
+
+///@endcond
+
+
+// ==========================================================================
+//
+// user interface
+//
+// ==========================================================================
+
+/// an expression for the elements of a span
+template< typename Q >
+constexpr auto lazy( quantity_span< Q > span ){
+   return terminal< Q >( span );
+}
+
+/// an expression for the elements of a quantity array
+template< typename V, typename T >
+auto lazy( quantity_array< V, T > & array ){
+   return lazy( array.span() );
+}
+
+/// an expression for the elements of a quantity array
+template< typename V, typename T >
+auto lazy( const quantity_array< V, T > & array ){
+   return lazy( array.span() );
+}
+
+/// an expression with the value of a quantity for each element
+template< typename V, typename T >
+constexpr auto lazy( const quantity_implementation< V, T > & q ){
+   return scalar< V, T >( q.raw() );
+}
+
+/// add two expressions of the same tag type
+template< typename L, typename R >
+///@cond INTERNAL
+requires
+   operand< L > && operand< R >
+   && ( expression< L > || expression< R > )
+   && same_tags< L, R >
+///@endcond
+constexpr auto operator+( const L & left, const R & right ){
+   return make_binary< plus >( left, right );
+}
+
+/// subtract two expressions of the same tag type
+template< typename L, typename R >
+///@cond INTERNAL
+requires
+   operand< L > && operand< R >
+   && ( expression< L > || expression< R > )
+   && same_tags< L, R >
+///@endcond
+constexpr auto operator-( const L & left, const R & right ){
+   return make_binary< minus >( left, right );
+}
+
+/// multiply two expressions
+template< typename L, typename R >
+///@cond INTERNAL
+requires
+   operand< L > && operand< R >
+   && ( expression< L > || expression< R > )
+///@endcond
+constexpr auto operator*( const L & left, const R & right ){
+   return make_binary< multiplies >( left, right );
+}
+
+/// divide two expressions
+template< typename L, typename R >
+///@cond INTERNAL
+requires
+   operand< L > && operand< R >
+   && ( expression< L > || expression< R > )
+///@endcond
+constexpr auto operator/( const L & left, const R & right ){
+   return make_binary< divides >( left, right );
+}
+
+/// compute all elements of an expression into a span, in one pass
+//
+/// Returns false, without changing out, when a span of
+/// the expression has fewer elements than out.
+template< typename E, typename Q >
+///@cond INTERNAL
+requires
+   expression< E >
+   && type_multiset::equal< typename Q::tags, typename E::tags >::value
+///@endcond
+bool evaluate( quantity_span< Q > out, const E & e ){
+   if( e.size() < out.size() ){
+      return false;
+   }
+   quantity_parallel::for_chunks( out.size(),
+      [ & e, dst = out.raw() ]( std::size_t, std::size_t begin, std::size_t end ){
+         for( std::size_t i = begin; i < end; ++i ){
+            dst[ i ] = e.at( i );
+         }
+      } );
+   return true;
+}
+
+}; // namespace quantity_expressions
+
+#endif // ifndef quantity_expressions_hpp
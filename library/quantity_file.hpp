@@ -0,0 +1,571 @@
+// ==========================================================================
+//
+// quantity_file.hpp
+//
+// a file format for a column of quantities that can be used
+// in place, through a memory mapping
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_file_hpp
+#define quantity_file_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_file
+///
+/// A quantity file holds a column of quantities of one type.
+/// It is written with a quantity_file::writer< V, T >, and read
+/// with a quantity_file::reader< V, T >, which maps the file
+/// into memory and gives a span of its values without copying
+/// or parsing them.
+/// The pages of the file are read by the operating system when
+/// they are first accessed, so opening even a huge file is fast.
+/// Both use the POSIX file and mmap interfaces.
+///
+/// The file starts with a header of 64 bytes:
+///
+///    - the magic string "QUANTITY"
+///    - the base type code: the kind (1 = signed integer,
+///      2 = unsigned integer, 3 = floating point) times 256
+///      plus the size in bytes
+///    - the fingerprint of the tag type (type_multiset::fingerprint)
+///    - the number of values
+///    - the offset of the first value in the file (64)
+///    - the offset of the zone map (0 when there is none)
+///    - the number of values per zone
+///    - a reserved word
+///
+/// The fields are 64-bit unsigned integers in the byte order of the
+/// host, the values follow the header as an array of base values.
+/// The reader checks the magic string, the base type and the
+/// fingerprint against its V and T when it opens a file.
+///
+/// The writer also writes a zone map after the values: for each
+/// block of zone_size values the smallest and the largest value,
+/// and their sum.
+/// A zone that contains a NaN has NaN as its smallest and largest
+/// value, the sum of its other values, and is never skipped.
+/// A query on the reader, for instance
+/// reader.count( quantity_file::greater( 5 * bar ) ),
+/// uses the zone map to skip the blocks that can't contain a match,
+/// and to count or sum the blocks in which all values match without
+/// reading their values.
+/// A condition compares with quantities of the file's own type,
+/// so a query against a quantity of another tag type doesn't compile.
+//
+// ==========================================================================
+
+namespace quantity_file {
+
+/// the result of a file operation
+enum class error {
+   none,                ///< no error
+   cannot_open,         ///< the file can't be opened, created or mapped
+   cannot_write,        ///< writing to the file failed
+   not_a_quantity_file, ///< the file doesn't start with the magic string
+   wrong_value_type,    ///< the file holds values of another base type
+   wrong_dimension,     ///< the file holds values of another tag type
+   truncated,           ///< the file is shorter than its header says
+   bad_zone_size,       ///< the writer was created with a zone size of 0
+};
+
+/// the file header
+struct header {
+   char          magic[ 8 ];
+   std::uint64_t value_type;
+   std::uint64_t fingerprint;
+   std::uint64_t count;
+   std::uint64_t data_offset;
+   std::uint64_t zone_offset;
+   std::uint64_t zone_size;
+   std::uint64_t reserved;
+};
+
+static_assert( sizeof( header ) == 64, "the header must be 64 bytes" );
+
+/// the magic string at the start of a quantity file
+constexpr char magic[ 8 ] = { 'Q', 'U', 'A', 'N', 'T', 'I', 'T', 'Y' };
+
+/// the code for the base type V in the header
+template< typename V >
+constexpr std::uint64_t value_type_code(){
+   static_assert( std::is_arithmetic< V >::value,
+      "a quantity file requires an arithmetic base type" );
+   return 256 * (
+      std::is_floating_point< V >::value ? 3
+      : std::is_signed< V >::value ? 1 : 2
+   ) + sizeof( V );
+}
+
+/// the default number of values summarized by one zone map entry
+constexpr std::uint64_t default_zone_size = 4096;
+
+/// the type of the sum of base values of type V in a zone
+template< typename V >
+using sum_type = typename std::conditional<
+   std::is_floating_point< V >::value, double,
+   typename std::conditional<
+      std::is_signed< V >::value, std::int64_t, std::uint64_t
+   >::type
+>::type;
+
+/// a zone map entry: a summary of a block of values
+template< typename V >
+struct zone {
+   V min;
+   V max;
+   sum_type< V > sum;
+};
+
+/// the header for n values of quantity_implementation< V, T >
+template< typename V, typename T >
+header make_header( std::uint64_t n ){
+   header h {};
+   std::memcpy( h.magic, magic, sizeof( magic ) );
+   h.value_type  = value_type_code< V >();
+   h.fingerprint = type_multiset::fingerprint< T >::value;
+   h.count       = n;
+   h.data_offset = sizeof( header );
+   return h;
+}
+
+/// check a header against the quantity_implementation< V, T >
+template< typename V, typename T >
+error check_header( const header & h ){
+   if( std::memcmp( h.magic, magic, sizeof( magic ) ) != 0 ){
+      return error::not_a_quantity_file;
+   }
+   if( h.value_type != value_type_code< V >() ){
+      return error::wrong_value_type;
+   }
+   if( h.fingerprint != type_multiset::fingerprint< T >::value ){
+      return error::wrong_dimension;
+   }
+   return error::none;
+}
+
+
+// ==========================================================================
+//
+// writer
+//
+// ==========================================================================
+
+/// writes a quantity file
+//
+/// The count in the header is written by close(),
+/// which is also called by the destructor.
+template< typename V, typename T >
+class writer {
+public:
+
+   /// the quantity type of the values
+   using quantity_type = quantity_implementation< V, T >;
+
+private:
+
+   int fd = -1;
+   std::uint64_t n = 0;
+   std::uint64_t zone_size;
+   std::vector< zone< V > > zones;
+
+   // write all bytes, retrying after partial writes
+   error write_bytes( const void * data, std::size_t size ){
+      auto p = static_cast< const char * >( data );
+      while( size > 0 ){
+         auto done = ::write( fd, p, size );
+         if( done <= 0 ){
+            return error::cannot_write;
+         }
+         p += done;
+         size -= done;
+      }
+      return error::none;
+   }
+
+public:
+
+   /// create a writer that summarizes each zone_size values
+   //
+   /// A zone_size of 0 is rejected by open().
+   explicit writer( std::uint64_t zone_size = default_zone_size ):
+      zone_size( zone_size )
+   {}
+
+   writer( const writer & ) = delete;
+   writer & operator=( const writer & ) = delete;
+
+   ~writer(){
+      close();
+   }
+
+   /// create (or truncate) the file, and write a header for 0 values
+   error open( const char * path ){
+      close();
+      if( zone_size == 0 ){
+         return error::bad_zone_size;
+      }
+      fd = ::open( path, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      if( fd < 0 ){
+         return error::cannot_open;
+      }
+      n = 0;
+      zones.clear();
+      const auto h = make_header< V, T >( 0 );
+      return write_bytes( & h, sizeof( h ) );
+   }
+
+   /// append values
+   error write( quantity_span< const quantity_type > values ){
+      auto result = write_bytes( values.raw(), values.size() * sizeof( V ) );
+      if( result != error::none ){
+         return result;
+      }
+      const V * src = values.raw();
+      for( std::size_t i = 0; i < values.size(); ++i, ++n ){
+         if( n % zone_size == 0 ){
+            zones.push_back( zone< V >{ src[ i ], src[ i ], 0 } );
+         }
+         auto & z = zones.back();
+         if( src[ i ] != src[ i ] ){
+
+            // a NaN: no comparison with it is true,
+            // so it remains the min and max of the zone
+            z.min = z.max = src[ i ];
+            continue;
+         }
+         z.min = src[ i ] < z.min ? src[ i ] : z.min;
+         z.max = z.max < src[ i ] ? src[ i ] : z.max;
+         z.sum += src[ i ];
+      }
+      return result;
+   }
+
+   /// write the final header and close the file
+   error close(){
+      if( fd < 0 ){
+         return error::none;
+      }
+
+      // the zone map, aligned after the values
+      auto h = make_header< V, T >( n );
+      const auto end = h.data_offset + n * sizeof( V );
+      const auto align = alignof( zone< V > );
+      h.zone_offset = ( end + align - 1 ) / align * align;
+      h.zone_size   = zone_size;
+      const char padding[ align ] = {};
+      auto result = write_bytes( padding, h.zone_offset - end );
+      if( result == error::none ){
+         result = write_bytes(
+            zones.data(), zones.size() * sizeof( zone< V > ) );
+      }
+
+      if( result == error::none
+         && ::pwrite( fd, & h, sizeof( h ), 0 ) != sizeof( h )
+      ){
+         result = error::cannot_write;
+      }
+      if( ::close( fd ) != 0 ){
+         result = error::cannot_write;
+      }
+      fd = -1;
+      return result;
+   }
+
+   /// the number of values written
+   std::uint64_t size() const {
+      return n;
+   }
+};
+
+
+// ==========================================================================
+//
+// query conditions
+//
+// ==========================================================================
+
+/// a condition on the values of quantity_implementation< V, T >
+//
+/// A value matches when it is within the (optional) low and
+/// high limits, so a NaN never matches.
+template< typename V, typename T >
+struct condition {
+   bool has_low       = false;
+   bool low_included  = false;
+   V    low           = V();
+   bool has_high      = false;
+   bool high_included = false;
+   V    high          = V();
+
+   /// whether the base value x matches
+   bool matches( const V & x ) const {
+      return
+         ( ! has_low  || ( low_included  ? low <= x  : low < x  ) )
+         && ( ! has_high || ( high_included ? x <= high : x < high ) );
+   }
+
+   /// whether a value in [ min, max ] could match
+   bool overlaps( const V & min, const V & max ) const {
+      return
+         ( ! has_low  || ( low_included  ? low <= max  : low < max  ) )
+         && ( ! has_high || ( high_included ? min <= high : min < high ) );
+   }
+};
+
+/// the values larger than q
+template< typename V, typename T >
+condition< V, T > greater( const quantity_implementation< V, T > & q ){
+   condition< V, T > c;
+   c.has_low = true;
+   c.low = q.raw();
+   return c;
+}
+
+/// the values larger than or equal to q
+template< typename V, typename T >
+condition< V, T > greater_equal( const quantity_implementation< V, T > & q ){
+   auto c = greater( q );
+   c.low_included = true;
+   return c;
+}
+
+/// the values smaller than q
+template< typename V, typename T >
+condition< V, T > less( const quantity_implementation< V, T > & q ){
+   condition< V, T > c;
+   c.has_high = true;
+   c.high = q.raw();
+   return c;
+}
+
+/// the values smaller than or equal to q
+template< typename V, typename T >
+condition< V, T > less_equal( const quantity_implementation< V, T > & q ){
+   auto c = less( q );
+   c.high_included = true;
+   return c;
+}
+
+/// the values in [ low, high ]
+template< typename V, typename T >
+condition< V, T > between(
+   const quantity_implementation< V, T > & low,
+   const quantity_implementation< V, T > & high
+){
+   auto c = greater_equal( low );
+   c.has_high = true;
+   c.high_included = true;
+   c.high = high.raw();
+   return c;
+}
+
+
+// ==========================================================================
+//
+// reader
+//
+// ==========================================================================
+
+/// maps a quantity file into memory
+template< typename V, typename T >
+class reader {
+public:
+
+   /// the quantity type of the values
+   using quantity_type = quantity_implementation< V, T >;
+
+private:
+
+   void * base = MAP_FAILED;
+   std::size_t length = 0;
+   const quantity_type * values = nullptr;
+   std::size_t n = 0;
+   const zone< V > * zones = nullptr;
+   std::size_t zone_size = 0;
+
+   // call f( begin, end, all ) for each zone that can contain a match,
+   // all is true when all values in the zone match
+   template< typename F >
+   void for_each_zone( const condition< V, T > & c, F f ) const {
+      if( zones == nullptr ){
+         f( 0, n, false );
+         return;
+      }
+      for( std::size_t begin = 0, k = 0; begin < n; begin += zone_size, ++k ){
+         const auto end = begin + zone_size < n ? begin + zone_size : n;
+         const auto & z = zones[ k ];
+         if( z.min != z.min ){
+
+            // the zone contains a NaN, so min and max say nothing
+            f( begin, end, false );
+         } else if( c.overlaps( z.min, z.max ) ){
+            f( begin, end, c.matches( z.min ) && c.matches( z.max ) );
+         }
+      }
+   }
+
+public:
+
+   reader() = default;
+   reader( const reader & ) = delete;
+   reader & operator=( const reader & ) = delete;
+
+   ~reader(){
+      close();
+   }
+
+   /// map a file, and check that it holds quantity_implementation< V, T >
+   error open( const char * path ){
+      close();
+      const int fd = ::open( path, O_RDONLY );
+      if( fd < 0 ){
+         return error::cannot_open;
+      }
+      struct stat s;
+      if( ::fstat( fd, & s ) != 0 ){
+         ::close( fd );
+         return error::cannot_open;
+      }
+      if( std::size_t( s.st_size ) < sizeof( header ) ){
+         ::close( fd );
+         return error::not_a_quantity_file;
+      }
+      length = s.st_size;
+      base = ::mmap( nullptr, length, PROT_READ, MAP_SHARED, fd, 0 );
+      ::close( fd );
+      if( base == MAP_FAILED ){
+         return error::cannot_open;
+      }
+
+      const auto & h = * static_cast< const header * >( base );
+      auto result = check_header< V, T >( h );
+      if( result == error::none && (
+         h.data_offset % alignof( V ) != 0
+         || h.data_offset > length
+         || ( length - h.data_offset ) / sizeof( V ) < h.count
+      )){
+         result = error::truncated;
+      }
+      if( result == error::none && h.zone_offset != 0 && (
+         h.zone_size == 0
+         || h.zone_offset % alignof( zone< V > ) != 0
+         || h.zone_offset > length
+         || ( length - h.zone_offset ) / sizeof( zone< V > )
+            < ( h.count + h.zone_size - 1 ) / h.zone_size
+      )){
+         result = error::truncated;
+      }
+      if( result != error::none ){
+         close();
+         return result;
+      }
+
+      values = reinterpret_cast< const quantity_type * >(
+         static_cast< const char * >( base ) + h.data_offset );
+      n = h.count;
+      if( h.zone_offset != 0 ){
+         zones = reinterpret_cast< const zone< V > * >(
+            static_cast< const char * >( base ) + h.zone_offset );
+         zone_size = h.zone_size;
+      }
+      return error::none;
+   }
+
+   /// unmap the file
+   void close(){
+      if( base != MAP_FAILED ){
+         ::munmap( base, length );
+      }
+      base = MAP_FAILED;
+      length = 0;
+      values = nullptr;
+      n = 0;
+      zones = nullptr;
+      zone_size = 0;
+   }
+
+   /// the values in the file (valid until close())
+   quantity_span< const quantity_type > span() const {
+      return quantity_span< const quantity_type >( values, n );
+   }
+
+   /// the number of values in the file
+   std::size_t size() const {
+      return n;
+   }
+
+   /// the number of values that match the condition
+   std::size_t count( const condition< V, T > & c ) const {
+      std::size_t k = 0;
+      for_each_zone( c, [ & ]( std::size_t begin, std::size_t end, bool all ){
+         if( all ){
+            k += end - begin;
+            return;
+         }
+         const V * src = span().raw();
+         for( auto i = begin; i < end; ++i ){
+            k += c.matches( src[ i ] ) ? 1 : 0;
+         }
+      } );
+      return k;
+   }
+
+   /// the sum of the values that match the condition
+   quantity_implementation< sum_type< V >, T > sum(
+      const condition< V, T > & c
+   ) const {
+      sum_type< V > s = 0;
+      for_each_zone( c, [ & ]( std::size_t begin, std::size_t end, bool all ){
+         if( all && zones != nullptr ){
+            s += zones[ begin / zone_size ].sum;
+            return;
+         }
+         const V * src = span().raw();
+         for( auto i = begin; i < end; ++i ){
+            s += c.matches( src[ i ] ) ? src[ i ] : V( 0 );
+         }
+      } );
+      return quantity_implementation< sum_type< V >, T >::from_raw( s );
+   }
+
+   /// call f( index, quantity ) for each value that matches the condition
+   template< typename F >
+   void for_each( const condition< V, T > & c, F f ) const {
+      for_each_zone( c, [ & ]( std::size_t begin, std::size_t end, bool ){
+         const auto values = span();
+         for( auto i = begin; i < end; ++i ){
+            if( c.matches( values.raw()[ i ] ) ){
+               f( i, values[ i ] );
+            }
+         }
+      } );
+   }
+};
+
+}; // namespace quantity_file
+
+#endif // ifndef quantity_file_hpp
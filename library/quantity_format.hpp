@@ -0,0 +1,247 @@
+// ==========================================================================
+//
+// quantity_format.hpp
+//
+// formatting of quantities with a choice of unit style,
+// and a std::formatter for quantities (when std::format is available)
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_format_hpp
+#define quantity_format_hpp
+
+#include <charconv>
+#include <cstddef>
+#include <system_error>
+#include <type_traits>
+#if __has_include( <version> )
+   #include <version>
+#endif
+#ifdef __cpp_lib_format
+   #include <format>
+#endif
+#include "quantity.hpp"
+#include "quantity_charconv.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_format
+///
+/// A quantity is formatted as its base value followed by its tags,
+/// in one of three unit styles (quantity_format::unit):
+///
+/// compact
+///    the unit suffix type_multiset::name_v, directly after the
+///    value, as written by to_chars: 17a3b2kg
+///
+/// exponent
+///    a space, and the tags separated by spaces, with their
+///    multiplicity after a ^: 17 a^3 b^2 kg
+///
+/// none
+///    only the value: 17
+///
+/// quantity_format::write_unit< T >( out, style ) writes the unit of
+/// tag type T to an output iterator.
+///
+/// to_chars( first, last, quantity, style ) is to_chars with a unit
+/// style, to_chars( first, last, quantity, format, precision, style )
+/// also has the format and precision of std::to_chars for a
+/// floating point base value.
+///
+/// When std::format is available (__cpp_lib_format), a
+/// std::formatter< quantity_implementation< V, T > > is provided.
+/// Its format specification is that of V, optionally preceded by
+/// a unit style letter (c, e or n) and a |:
+///
+/// std::format( "{:.2f}", q )  ==>  "17.00a3b2kg"
+/// std::format( "{:e|}", q )   ==>  "17 a^3 b^2 kg"
+/// std::format( "{:n|>6}", q ) ==>  "    17"
+///
+/// The value is formatted by std::formatter< V >, and the unit is
+/// written directly to the output iterator.
+//
+// ==========================================================================
+
+namespace quantity_format {
+
+/// the style in which the tags of a quantity are written
+enum class unit {
+   compact,    ///< the unit suffix, directly after the value
+   exponent,   ///< space-separated tags, multiplicities after a ^
+   none,       ///< no unit
+};
+
+///@cond INTERNAL
+
+// write the name of each element, and its count unless that is 1,
+// preceded by a space
+template< typename Data, int Count, typename Tail >
+struct exponent_recursor {
+   template< typename OutputIt >
+   static OutputIt write( OutputIt out ){
+      *out++ = ' ';
+      for( unsigned int i = 0; i < type_multiset::name_length( Data::name ); ++i ){
+         *out++ = type_multiset::name_at( Data::name, i );
+      }
+      if( Count != 1 ){
+         char buffer[ 12 ];
+         const auto end = std::to_chars( buffer, buffer + 12, Count ).ptr;
+         *out++ = '^';
+         for( const char * p = buffer; p != end; ++p ){
+            *out++ = *p;
+         }
+      }
+      return exponent_recursor<
+         typename Tail::data, Tail::count, typename Tail::tail
+      >::write( out );
+   }
+};
+
+template<>
+struct exponent_recursor< void, 0, void > {
+   template< typename OutputIt >
+   static OutputIt write( OutputIt out ){
+      return out;
+   }
+};
+
+///@endcond
+
+/// write the unit of tag type T in the given style
+template< typename T, typename OutputIt >
+OutputIt write_unit( OutputIt out, unit style ){
+   if( style == unit::compact ){
+      for( const char * p = type_multiset::name_v< T >; *p != '\0'; ++p ){
+         *out++ = *p;
+      }
+   } else if( style == unit::exponent ){
+      using list = type_multiset::canonical< T >;
+      out = exponent_recursor<
+         typename list::data, list::count, typename list::tail
+      >::write( out );
+   }
+   return out;
+}
+
+///@cond INTERNAL
+
+// write the unit after a successful std::to_chars
+template< typename T >
+std::to_chars_result finish( std::to_chars_result result, char * last,
+   unit style
+){
+   if( result.ec != std::errc() ){
+      return result;
+   }
+
+   // a counting output iterator, that stops at last
+   struct bounded {
+      char * p;
+      char * last;
+      bool full;
+      bounded & operator*(){ return *this; }
+      bounded & operator++( int ){ return *this; }
+      bounded & operator=( char c ){
+         if( p == last ){
+            full = true;
+         } else {
+            *p++ = c;
+         }
+         return *this;
+      }
+   };
+
+   const auto out = write_unit< T >( bounded{ result.ptr, last, false }, style );
+   if( out.full ){
+      return { last, std::errc::value_too_large };
+   }
+   return { out.p, std::errc() };
+}
+
+///@endcond
+
+}; // namespace quantity_format
+
+
+/// write a quantity as characters, with the unit in the given style
+template< typename V, typename T >
+std::to_chars_result to_chars(
+   char * first, char * last,
+   const quantity_implementation< V, T > & q,
+   quantity_format::unit style
+){
+   return quantity_format::finish< T >(
+      std::to_chars( first, last, q.raw() ), last, style );
+}
+
+/// write a quantity with a floating point base value as characters,
+/// with the format and precision of std::to_chars and the unit
+/// in the given style
+template< typename V, typename T >
+///@cond INTERNAL
+requires std::is_floating_point< V >::value
+///@endcond
+std::to_chars_result to_chars(
+   char * first, char * last,
+   const quantity_implementation< V, T > & q,
+   std::chars_format format, int precision,
+   quantity_format::unit style = quantity_format::unit::compact
+){
+   return quantity_format::finish< T >(
+      std::to_chars( first, last, q.raw(), format, precision ), last, style );
+}
+
+
+// ==========================================================================
+//
+// std::formatter
+//
+// ==========================================================================
+
+#ifdef __cpp_lib_format
+
+/// std::format support for quantities
+template< typename V, typename T >
+struct std::formatter< quantity_implementation< V, T >, char > {
+
+   std::formatter< V, char > value_formatter;
+   quantity_format::unit style = quantity_format::unit::compact;
+
+   constexpr auto parse( std::format_parse_context & context ){
+      auto it = context.begin();
+      if( context.end() - it >= 2 && it[ 1 ] == '|' ){
+         switch( it[ 0 ] ){
+            case 'c': style = quantity_format::unit::compact;  break;
+            case 'e': style = quantity_format::unit::exponent; break;
+            case 'n': style = quantity_format::unit::none;     break;
+            default: throw std::format_error( "invalid quantity unit style" );
+         }
+         context.advance_to( it + 2 );
+      }
+      return value_formatter.parse( context );
+   }
+
+   template< typename FormatContext >
+   auto format(
+      const quantity_implementation< V, T > & q,
+      FormatContext & context
+   ) const {
+      auto out = value_formatter.format( q.raw(), context );
+      return quantity_format::write_unit< T >( out, style );
+   }
+};
+
+#endif // ifdef __cpp_lib_format
+
+#endif // ifndef quantity_format_hpp
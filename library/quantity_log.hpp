@@ -0,0 +1,532 @@
+// ==========================================================================
+//
+// quantity_log.hpp
+//
+// a binary event log of quantities, formatted later by a decoder
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_log_hpp
+#define quantity_log_hpp
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "quantity.hpp"
+#include "quantity_file.hpp"
+#include "quantity_export.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_log
+///
+/// The quantity log records events in a binary form, and leaves
+/// the formatting to a decoder that runs later (offline).
+/// It lives in the namespace quantity_log.
+///
+/// A log site is a static quantity_log::site< V, T > object that
+/// holds the format text of the event, for instance
+///
+///    static const quantity_log::site< double, pressure > inlet(
+///       "inlet pressure {}" );
+///
+/// A logger writes an event with log.write( inlet, p ).
+/// This appends only a site number, a timestamp (in ns) and the
+/// base value of p to the buffer of the logger.
+/// The first time a logger writes an event of a site, it also
+/// writes a description of the site: its format text,
+/// the unit (type_multiset::name_v of T) and the base type of V.
+///
+/// The timestamp is read from CLOCK_MONOTONIC_COARSE (where it
+/// exists, otherwise from steady_clock), which is much faster to read
+/// than steady_clock, but has the resolution of a clock tick
+/// (typically 1 to 4 ms).
+/// log.write( site, p, timestamp ) logs an event with a timestamp
+/// from another clock.
+///
+/// A logger has two buffers of a fixed size.
+/// When the one that is being filled is full, it is handed to
+/// a writer thread of the logger, which writes it to the file
+/// (with write()) while the other buffer is filled.
+/// Only when the writer thread is still busy with the other buffer
+/// does a write() of an event wait for it.
+/// flush() and close() wait until all events have been written.
+/// A logger must be used by one thread at a time,
+/// each thread can have its own logger and file.
+///
+/// A decoder reads the events of a log, and formats each as its
+/// format text in which {} is replaced by the value
+/// and the unit (as to_chars writes them).
+/// decode( log_path, text_path ) writes the decoded events of a
+/// log file to a text file, one "timestamp: text" line per event.
+//
+// ==========================================================================
+
+namespace quantity_log {
+
+/// the result of a log operation
+enum class error {
+   none,          ///< no error (yet)
+   end,           ///< all events have been decoded
+   cannot_open,   ///< a file can't be opened, created or mapped
+   cannot_write,  ///< writing to the file failed
+   truncated,     ///< the log ends within a record, or is corrupt
+};
+
+///@cond INTERNAL
+
+// the record kinds
+constexpr unsigned char site_record  = 1;
+constexpr unsigned char event_record = 2;
+
+// the number of the next site
+inline std::atomic< std::uint32_t > next_site{ 0 };
+
+// the current time in ns, from a fast clock with a coarse resolution
+inline std::uint64_t now(){
+#ifdef CLOCK_MONOTONIC_COARSE
+   timespec t;
+   ::clock_gettime( CLOCK_MONOTONIC_COARSE, & t );
+   return std::uint64_t( t.tv_sec ) * 1'000'000'000 + t.tv_nsec;
+#else
+   return std::uint64_t(
+      std::chrono::duration_cast< std::chrono::nanoseconds >(
+         std::chrono::steady_clock::now().time_since_epoch() ).count() );
+#endif
+}
+
+///@endcond
+
+/// a place in the code that logs quantity_implementation< V, T > values
+template< typename V, typename T >
+class site {
+public:
+
+   /// the number of the site
+   const std::uint32_t number;
+
+   /// the format text, {} is replaced by the value
+   const char * const format;
+
+   /// create a site, format must remain valid (a string literal)
+   explicit site( const char * format ):
+      number( next_site++ ), format( format )
+   {}
+};
+
+/// writes events to a log file
+class logger {
+private:
+
+   std::vector< unsigned char > buffer;
+   std::size_t used = 0;
+   std::vector< bool > described;
+   int fd = -1;
+
+   // the writer thread owns spare while pending is not 0,
+   // the other members below are guarded by the mutex
+   std::vector< unsigned char > spare;
+   std::size_t pending = 0;
+   bool stopping = false;
+   error state = error::none;
+   mutable std::mutex mutex;
+   std::condition_variable changed;
+   std::thread writer;
+
+   template< typename X >
+   void put( const X & x ){
+      std::memcpy( buffer.data() + used, & x, sizeof( X ) );
+      used += sizeof( X );
+   }
+
+   // write the spare buffers that are handed to the writer thread
+   void write_spares(){
+      std::unique_lock< std::mutex > lock( mutex );
+      for(;;){
+         changed.wait( lock, [ this ]{ return pending > 0 || stopping; } );
+         if( pending == 0 ){
+            return;
+         }
+         const unsigned char * p = spare.data();
+         auto rest = pending;
+         auto result = state;
+         lock.unlock();
+         while( result == error::none && rest > 0 ){
+            const auto n = ::write( fd, p, rest );
+            if( n <= 0 ){
+               result = error::cannot_write;
+            } else {
+               p += n;
+               rest -= n;
+            }
+         }
+         lock.lock();
+         state = result;
+         pending = 0;
+         changed.notify_all();
+      }
+   }
+
+   // hand the buffer to the writer thread, and continue with the spare
+   void hand_off(){
+      if( ! writer.joinable() ){
+
+         // no file is open
+         std::lock_guard< std::mutex > lock( mutex );
+         if( used > 0 && state == error::none ){
+            state = error::cannot_write;
+         }
+         used = 0;
+         return;
+      }
+      std::unique_lock< std::mutex > lock( mutex );
+      changed.wait( lock, [ this ]{ return pending == 0; } );
+      std::swap( buffer, spare );
+      pending = used;
+      used = 0;
+      changed.notify_all();
+   }
+
+   void reserve( std::size_t n ){
+      if( buffer.size() - used < n ){
+         hand_off();
+         if( buffer.size() < n ){
+            buffer.resize( n );
+         }
+      }
+   }
+
+   template< typename V, typename T >
+   void describe( const site< V, T > & s ){
+      if( described.size() <= s.number ){
+         described.resize( s.number + 1, false );
+      }
+      described[ s.number ] = true;
+      const auto format_length = std::uint16_t( std::strlen( s.format ) );
+      const auto unit_length =
+         std::uint16_t( sizeof( type_multiset::name_v< T > ) - 1 );
+      reserve( 11 + format_length + unit_length );
+      put( site_record );
+      put( s.number );
+      put( std::uint16_t( quantity_file::value_type_code< V >() ) );
+      put( format_length );
+      put( unit_length );
+      std::memcpy( buffer.data() + used, s.format, format_length );
+      used += format_length;
+      std::memcpy( buffer.data() + used, type_multiset::name_v< T >, unit_length );
+      used += unit_length;
+   }
+
+public:
+
+   /// create a logger with a buffer of size bytes
+   explicit logger( std::size_t size = 1 << 16 ):
+      buffer( size < 64 ? 64 : size ), spare( buffer.size() )
+   {}
+
+   logger( const logger & ) = delete;
+   logger & operator=( const logger & ) = delete;
+
+   ~logger(){
+      close();
+   }
+
+   /// create (or truncate) a log file, close the current one
+   error open( const char * path ){
+      close();
+      described.clear();
+      used = 0;
+      fd = ::open( path, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      std::lock_guard< std::mutex > lock( mutex );
+      state = fd < 0 ? error::cannot_open : error::none;
+      if( fd >= 0 ){
+         stopping = false;
+         writer = std::thread( [ this ]{ write_spares(); } );
+      }
+      return state;
+   }
+
+   /// write the buffered events to the file, wait until that is done
+   void flush(){
+      hand_off();
+      std::unique_lock< std::mutex > lock( mutex );
+      changed.wait( lock, [ this ]{ return pending == 0; } );
+   }
+
+   /// flush and close the file, return the state
+   error close(){
+      if( fd >= 0 ){
+         flush();
+         {
+            std::lock_guard< std::mutex > lock( mutex );
+            stopping = true;
+            changed.notify_all();
+         }
+         writer.join();
+         ::close( fd );
+         fd = -1;
+      }
+      return status();
+   }
+
+   /// the state of the logger
+   error status() const {
+      std::lock_guard< std::mutex > lock( mutex );
+      return state;
+   }
+
+   /// log an event with the current time
+   template< typename V, typename T >
+   void write( const site< V, T > & s, const quantity_implementation< V, T > & q ){
+      write( s, q, now() );
+   }
+
+   /// log an event with the given timestamp
+   template< typename V, typename T >
+   void write(
+      const site< V, T > & s, const quantity_implementation< V, T > & q,
+      std::uint64_t timestamp
+   ){
+      if( s.number >= described.size() || ! described[ s.number ] ){
+         describe( s );
+      }
+      reserve( 13 + sizeof( V ) );
+      put( event_record );
+      put( s.number );
+      put( timestamp );
+      put( q.raw() );
+   }
+};
+
+
+// ==========================================================================
+//
+// decoder
+//
+// ==========================================================================
+
+/// a decoded event
+struct event {
+
+   /// the timestamp of the event
+   std::uint64_t timestamp;
+
+   /// the formatted event
+   std::string text;
+};
+
+/// decodes the events of a log
+class decoder {
+private:
+
+   struct description {
+      std::uint16_t value_type = 0;
+      std::string format;
+      std::string unit;
+   };
+
+   const unsigned char * next;
+   const unsigned char * last;
+   std::vector< description > sites;
+   error state = error::none;
+
+   template< typename X >
+   X get(){
+      X x;
+      std::memcpy( & x, next, sizeof( X ) );
+      next += sizeof( X );
+      return x;
+   }
+
+   bool available( std::size_t n ){
+      if( std::size_t( last - next ) < n ){
+         state = error::truncated;
+         return false;
+      }
+      return true;
+   }
+
+   template< typename V >
+   char * value( char * p, char * end ){
+      return std::to_chars( p, end, get< V >() ).ptr;
+   }
+
+   // the size of a value of base type code, or 0 if it is not known
+   static std::size_t value_size( std::uint16_t code ){
+      const auto size = code % 256;
+      switch( code / 256 ){
+         case 1:
+         case 2:  return size == 1 || size == 2 || size == 4 || size == 8
+                     ? size : 0;
+         case 3:  return size == sizeof( float ) || size == sizeof( double )
+                     ? size : 0;
+         default: return 0;
+      }
+   }
+
+   // read a value of base type code and write it as text
+   char * value( std::uint16_t code, char * p, char * end ){
+      switch( code ){
+         case 256 + 1:  return value< std::int8_t   >( p, end );
+         case 256 + 2:  return value< std::int16_t  >( p, end );
+         case 256 + 4:  return value< std::int32_t  >( p, end );
+         case 256 + 8:  return value< std::int64_t  >( p, end );
+         case 512 + 1:  return value< std::uint8_t  >( p, end );
+         case 512 + 2:  return value< std::uint16_t >( p, end );
+         case 512 + 4:  return value< std::uint32_t >( p, end );
+         case 512 + 8:  return value< std::uint64_t >( p, end );
+         case 768 + sizeof( float ):  return value< float  >( p, end );
+         default:                     return value< double >( p, end );
+      }
+   }
+
+   bool read_site(){
+      if( ! available( 10 ) ){
+         return false;
+      }
+      const auto number        = get< std::uint32_t >();
+      const auto value_type    = get< std::uint16_t >();
+      const auto format_length = get< std::uint16_t >();
+      const auto unit_length   = get< std::uint16_t >();
+      if( value_size( value_type ) == 0
+         || ! available( format_length + unit_length )
+      ){
+         state = error::truncated;
+         return false;
+      }
+      if( sites.size() <= number ){
+         sites.resize( number + 1 );
+      }
+      auto & d = sites[ number ];
+      d.value_type = value_type;
+      d.format.assign( reinterpret_cast< const char * >( next ), format_length );
+      next += format_length;
+      d.unit.assign( reinterpret_cast< const char * >( next ), unit_length );
+      next += unit_length;
+      return true;
+   }
+
+public:
+
+   /// create a decoder for size bytes of a log
+   decoder( const unsigned char * data, std::size_t size ):
+      next( data ), last( data + size )
+   {}
+
+   /// decode the next event, return error::end after the last event
+   error read( event & e ){
+      while( state == error::none ){
+         if( next == last ){
+            return error::end;
+         }
+         const auto kind = get< unsigned char >();
+         if( kind == site_record ){
+            read_site();
+            continue;
+         }
+         if( kind != event_record || ! available( 12 ) ){
+            state = error::truncated;
+            break;
+         }
+         const auto number = get< std::uint32_t >();
+         const auto timestamp = get< std::uint64_t >();
+         if( number >= sites.size() || sites[ number ].value_type == 0
+            || ! available( value_size( sites[ number ].value_type ) )
+         ){
+            state = error::truncated;
+            break;
+         }
+         const auto & d = sites[ number ];
+         char text[ 64 ];
+         auto end = value( d.value_type, text, text + sizeof( text ) );
+         const auto field = d.format.find( "{}" );
+         e.timestamp = timestamp;
+         if( field == std::string::npos ){
+            e.text = d.format;
+            e.text += ' ';
+            e.text.append( text, end );
+            e.text += d.unit;
+         } else {
+            e.text.assign( d.format, 0, field );
+            e.text.append( text, end );
+            e.text += d.unit;
+            e.text.append( d.format, field + 2, std::string::npos );
+         }
+         return error::none;
+      }
+      return state;
+   }
+};
+
+/// decode a log file to a text file, one "timestamp: text" line per event
+inline error decode( const char * log_path, const char * text_path ){
+   const int fd = ::open( log_path, O_RDONLY );
+   if( fd < 0 ){
+      return error::cannot_open;
+   }
+   struct stat s;
+   if( ::fstat( fd, & s ) != 0 ){
+      ::close( fd );
+      return error::cannot_open;
+   }
+   const std::size_t length = s.st_size;
+   void * base = nullptr;
+   if( length > 0 ){
+      base = ::mmap( nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+   }
+   ::close( fd );
+   if( base == MAP_FAILED ){
+      return error::cannot_open;
+   }
+
+   quantity_export::writer out;
+   auto result = out.open( text_path ) == quantity_export::error::none
+      ? error::none : error::cannot_open;
+   decoder d( static_cast< const unsigned char * >( base ), length );
+   event e;
+   while( result == error::none ){
+      result = d.read( e );
+      if( result == error::none ){
+         out.reserve( quantity_export::max_value_size );
+         out.put_value( e.timestamp );
+         out.put( ": " );
+         out.put( e.text.data(), e.text.size() );
+         out.put( '\n' );
+      }
+   }
+   if( out.close() == quantity_export::error::cannot_write ){
+      result = error::cannot_write;
+   }
+   if( base != nullptr ){
+      ::munmap( base, length );
+   }
+   return result == error::end ? error::none : result;
+}
+
+}; // namespace quantity_log
+
+#endif // ifndef quantity_log_hpp
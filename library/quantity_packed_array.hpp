@@ -0,0 +1,236 @@
+// ==========================================================================
+//
+// quantity_packed_array.hpp
+//
+// an array of quantities that stores each base value in a fixed
+// number of bits
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_packed_array_hpp
+#define quantity_packed_array_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+
+// ==========================================================================
+//
+// packed array
+//
+// ==========================================================================
+
+/// array of quantities stored in Bits bits each
+//
+/// The base type V must be an integer type, and Bits must be in
+/// the range 1 .. 32 and not more than the number of bits of V.
+/// When V is signed the values are stored in two's complement
+/// and sign-extended when they are read.
+/// A value that doesn't fit in Bits bits is truncated.
+///
+/// The bits are stored in 64-bit words, element i occupies
+/// bits i * Bits ... i * Bits + Bits - 1.
+/// A 12-bit ADC value thus takes 12 bits instead of the 16 of
+/// a quantity< uint16_t, ... >.
+///
+/// Single elements are read with get() or [], and written with set().
+/// The bulk operations pack() and unpack() convert from and to
+/// spans of (unpacked) quantities, using loops without
+/// data-dependent branches.
+template< typename V, typename T, unsigned int Bits >
+class quantity_packed_array {
+public:
+
+   static_assert( std::is_integral< V >::value,
+      "the base type of a packed array must be an integer type" );
+   static_assert( Bits >= 1 && Bits <= 32 && Bits <= 8 * sizeof( V ),
+      "the number of bits must be in 1 .. 32 and fit in the base type" );
+
+   /// the quantity type of the elements
+   using quantity_type = quantity_implementation< V, T >;
+
+   /// the base type of the elements
+   using value_type    = V;
+
+   /// the tag type of the elements
+   using tags          = T;
+
+   /// the number of bits per element
+   static constexpr unsigned int bits = Bits;
+
+private:
+
+   using word = std::uint64_t;
+   using bits_type = typename std::make_unsigned< V >::type;
+
+   static constexpr word mask = ( word( 1 ) << Bits ) - 1;
+
+   // one extra word at the end, so reading the second word
+   // of the last element is always allowed
+   std::vector< word > words;
+   std::size_t n;
+
+   static std::size_t words_for( std::size_t n ){
+      return ( n * Bits + 63 ) / 64 + 1;
+   }
+
+   ///@cond INTERNAL
+   __attribute__((always_inline))
+   ///@endcond
+   static V extract( const word * w, std::size_t i ){
+      const auto bit   = i * Bits;
+      const auto k     = bit / 64;
+      const auto shift = bit % 64;
+
+      // the ( << 1 ) << ( 63 - shift ) avoids a shift by 64
+      const word x =
+         ( ( w[ k ] >> shift ) | ( ( w[ k + 1 ] << 1 ) << ( 63 - shift ) ) )
+         & mask;
+
+      if( std::is_signed< V >::value ){
+         const word sign = word( 1 ) << ( Bits - 1 );
+         return V( bits_type( ( x ^ sign ) - sign ) );
+      } else {
+         return V( x );
+      }
+   }
+
+   ///@cond INTERNAL
+   __attribute__((always_inline))
+   ///@endcond
+   static void insert( word * w, std::size_t i, V value ){
+      const auto bit   = i * Bits;
+      const auto k     = bit / 64;
+      const auto shift = bit % 64;
+      const word x     = word( bits_type( value ) ) & mask;
+      w[ k ]     = ( w[ k ] & ~( mask << shift ) ) | ( x << shift );
+      w[ k + 1 ] = ( w[ k + 1 ] & ~( ( mask >> 1 ) >> ( 63 - shift ) ) )
+         | ( ( x >> 1 ) >> ( 63 - shift ) );
+   }
+
+public:
+
+   /// iterator that reads the elements as quantities
+   class const_iterator {
+   private:
+      const quantity_packed_array * array;
+      std::size_t i;
+
+   public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type        = quantity_type;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = void;
+      using reference         = quantity_type;
+
+      const_iterator( const quantity_packed_array * array, std::size_t i ):
+         array( array ), i( i )
+      {}
+
+      quantity_type operator*() const { return array->get( i ); }
+
+      const_iterator & operator++(){ ++i; return *this; }
+
+      const_iterator operator++( int ){
+         auto old = *this;
+         ++i;
+         return old;
+      }
+
+      bool operator==( const const_iterator & right ) const {
+         return i == right.i;
+      }
+
+      bool operator!=( const const_iterator & right ) const {
+         return i != right.i;
+      }
+   };
+
+   /// create an empty array
+   quantity_packed_array():
+      words( words_for( 0 ), 0 ), n( 0 )
+   {}
+
+   /// create an array of size elements with base value 0
+   explicit quantity_packed_array( std::size_t size ):
+      words( words_for( size ), 0 ), n( size )
+   {}
+
+   /// the number of elements
+   std::size_t size() const { return n; }
+
+   /// change the number of elements, new elements have base value 0
+   void resize( std::size_t size ){
+      for( auto i = size; i < n; ++i ){
+         insert( words.data(), i, V( 0 ) );
+      }
+      words.resize( words_for( size ), 0 );
+      n = size;
+   }
+
+   /// the number of bytes used for the elements
+   std::size_t bytes() const { return words.size() * sizeof( word ); }
+
+   /// element i (not range-checked)
+   quantity_type get( std::size_t i ) const {
+      return quantity_type::from_raw( extract( words.data(), i ) );
+   }
+
+   /// element i (not range-checked)
+   quantity_type operator[]( std::size_t i ) const {
+      return get( i );
+   }
+
+   /// replace element i (not range-checked)
+   void set( std::size_t i, const quantity_type & q ){
+      insert( words.data(), i, q.raw() );
+   }
+
+   /// iterators
+   const_iterator begin() const { return const_iterator( this, 0 ); }
+   const_iterator end() const { return const_iterator( this, n ); }
+
+   /// replace the contents by the elements of in
+   void pack( quantity_span< const quantity_type > in ){
+      n = in.size();
+      words.assign( words_for( n ), 0 );
+      const V * src = in.raw();
+      word * w = words.data();
+      for( std::size_t i = 0; i < n; ++i ){
+         const auto bit   = i * Bits;
+         const auto shift = bit % 64;
+         const word x     = word( bits_type( src[ i ] ) ) & mask;
+         w[ bit / 64 ]     |= x << shift;
+         w[ bit / 64 + 1 ] |= ( x >> 1 ) >> ( 63 - shift );
+      }
+   }
+
+   /// copy the elements to out, which must have (at least) size() elements
+   void unpack( quantity_span< quantity_type > out ) const {
+      V * dst = out.raw();
+      const word * w = words.data();
+      for( std::size_t i = 0; i < n; ++i ){
+         dst[ i ] = extract( w, i );
+      }
+   }
+
+   /// the packed words (the elements start at bit 0 of word 0)
+   const std::uint64_t * data() const { return words.data(); }
+};
+
+#endif // ifndef quantity_packed_array_hpp
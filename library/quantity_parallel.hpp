@@ -0,0 +1,286 @@
+// ==========================================================================
+//
+// quantity_parallel.hpp
+//
+// splitting work on large quantity arrays over threads
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_parallel_hpp
+#define quantity_parallel_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// When the user has included <execution> before this file,
+// the std::execution policies are accepted too.
+// It is not included here, because with some standard libraries
+// that would require linking with TBB.
+#ifdef __cpp_lib_execution
+#include <execution>
+#endif
+
+// this file contains Doxygen lines
+/// @file
+
+namespace quantity_parallel {
+
+// ==========================================================================
+//
+// execution policies
+//
+// ==========================================================================
+
+/// policy: run in the calling thread only
+struct sequenced_policy {};
+
+/// policy: split large inputs over the threads of the pool
+struct parallel_policy {};
+
+/// the sequenced policy object
+constexpr sequenced_policy seq{};
+
+/// the parallel policy object
+constexpr parallel_policy par{};
+
+/// whether P is an accepted execution policy
+template< typename P >
+struct is_execution_policy : std::false_type {};
+
+template<> struct is_execution_policy< sequenced_policy > : std::true_type {};
+template<> struct is_execution_policy< parallel_policy >  : std::true_type {};
+
+/// whether the execution policy P allows using more than one thread
+template< typename P >
+struct is_parallel : std::true_type {};
+
+template<> struct is_parallel< sequenced_policy > : std::false_type {};
+
+///@cond INTERNAL
+#ifdef __cpp_lib_execution
+template< typename P >
+   requires std::is_execution_policy< P >::value
+struct is_execution_policy< P > : std::true_type {};
+
+template<>
+struct is_parallel< std::execution::sequenced_policy > : std::false_type {};
+
+// unseq allows vectorization, but only in the calling thread
+#if __cpp_lib_execution >= 201902L
+template<>
+struct is_parallel< std::execution::unsequenced_policy > : std::false_type {};
+#endif
+#endif
+
+template< typename P >
+concept bool execution_policy
+   = is_execution_policy< typename std::decay< P >::type >::value;
+///@endcond
+
+
+// ==========================================================================
+//
+// thread pool
+//
+// ==========================================================================
+
+/// smallest number of elements that is worth a thread of its own
+//
+/// Below this size the cost of handing work to a thread is larger than
+/// the work itself, so smaller arrays are handled by the
+/// calling thread alone.
+constexpr std::size_t grain = 1 << 16;
+
+/// a fixed set of worker threads that run the chunks of one job
+//
+/// The pool runs one job at a time.
+/// A job that is started while another one runs
+/// (for instance from inside a chunk) is run by the calling
+/// thread alone, so nested parallel calls can't deadlock.
+class thread_pool {
+private:
+
+   std::mutex                   mutex;
+   std::condition_variable      wake;
+   std::condition_variable      done;
+   std::vector< std::thread >   workers;
+   std::mutex                   busy;
+
+   const std::function< void( std::size_t ) > * job = nullptr;
+   std::size_t                  next       = 0;
+   std::size_t                  count      = 0;
+   std::size_t                  finished   = 0;
+   unsigned long                generation = 0;
+   bool                         stop       = false;
+
+   // claim and run chunks of the current job until none are left
+   void drain( std::unique_lock< std::mutex > & lock ){
+      while( next < count ){
+         auto c = next++;
+         lock.unlock();
+         ( *job )( c );
+         lock.lock();
+         if( ++finished == count ){
+            done.notify_all();
+         }
+      }
+   }
+
+   void work(){
+      std::unique_lock< std::mutex > lock( mutex );
+      unsigned long seen = 0;
+      for(;;){
+         wake.wait( lock, [ & ]{ return stop || generation != seen; } );
+         if( stop ){
+            return;
+         }
+         seen = generation;
+         drain( lock );
+      }
+   }
+
+public:
+
+   /// create a pool with n - 1 workers (the caller is the n-th thread)
+   explicit thread_pool( std::size_t n ){
+      for( std::size_t i = 1; i < n; ++i ){
+         workers.emplace_back( [ this ]{ work(); } );
+      }
+   }
+
+   thread_pool( const thread_pool & ) = delete;
+   thread_pool & operator=( const thread_pool & ) = delete;
+
+   ~thread_pool(){
+      {
+         std::lock_guard< std::mutex > lock( mutex );
+         stop = true;
+      }
+      wake.notify_all();
+      for( auto & t : workers ){
+         t.join();
+      }
+   }
+
+   /// the number of threads that can run chunks, including the caller
+   std::size_t threads() const {
+      return workers.size() + 1;
+   }
+
+   /// call f( c ) for c in [ 0, n ), and return when all calls are done
+   void run( std::size_t n, const std::function< void( std::size_t ) > & f ){
+      std::unique_lock< std::mutex > exclusive( busy, std::try_to_lock );
+      if( ! exclusive.owns_lock() || workers.empty() || n < 2 ){
+         for( std::size_t c = 0; c < n; ++c ){
+            f( c );
+         }
+         return;
+      }
+      std::unique_lock< std::mutex > lock( mutex );
+      job      = & f;
+      next     = 0;
+      count    = n;
+      finished = 0;
+      ++generation;
+      wake.notify_all();
+      drain( lock );
+      done.wait( lock, [ & ]{ return finished == count; } );
+      job = nullptr;
+   }
+};
+
+/// the pool used by the quantity algorithms
+inline thread_pool & pool(){
+   static thread_pool instance(
+      std::thread::hardware_concurrency() == 0
+         ? 1
+         : std::thread::hardware_concurrency() );
+   return instance;
+}
+
+
+// ==========================================================================
+//
+// chunks
+//
+// ==========================================================================
+
+///@cond INTERNAL
+inline std::atomic< std::size_t > & thread_limit(){
+   static std::atomic< std::size_t > limit{ 0 };
+   return limit;
+}
+///@endcond
+
+/// limit the number of threads that will be used to n (0: no limit)
+//
+/// This limits the number of chunks, the pool keeps its threads.
+/// It is meant for measuring how an algorithm scales.
+inline void limit_threads( std::size_t n ){
+   thread_limit().store( n, std::memory_order_relaxed );
+}
+
+/// the maximum number of threads that will be used
+inline std::size_t max_threads(){
+   const auto limit = thread_limit().load( std::memory_order_relaxed );
+   const auto n = pool().threads();
+   return limit != 0 && limit < n ? limit : n;
+}
+
+/// the number of chunks into which n elements will be split
+inline std::size_t chunks( std::size_t n ){
+   auto c = n / grain;
+   if( c > max_threads() ){
+      c = max_threads();
+   }
+   return c == 0 ? 1 : c;
+}
+
+/// the number of chunks into which n elements will be split
+/// under the execution policy P
+template< typename P >
+std::size_t chunks( const P &, std::size_t n ){
+   return is_parallel< P >::value ? chunks( n ) : 1;
+}
+
+/// the first element of chunk c (of count) for n elements
+inline std::size_t chunk_begin( std::size_t c, std::size_t count, std::size_t n ){
+   return ( n / count ) * c + ( c < n % count ? c : n % count );
+}
+
+/// call f( c, begin, end ) for each chunk c of count chunks of n elements
+//
+/// The chunks are processed by the threads of the pool,
+/// including the calling thread.
+/// This function returns when all chunks have been processed.
+template< typename F >
+void for_chunks( std::size_t n, std::size_t count, F f ){
+   pool().run( count, [ & f, count, n ]( std::size_t c ){
+      f( c, chunk_begin( c, count, n ), chunk_begin( c + 1, count, n ) );
+   } );
+}
+
+/// call f( c, begin, end ) for each chunk c of n elements
+//
+/// The chunks are the ones reported by chunks( n ).
+template< typename F >
+void for_chunks( std::size_t n, F f ){
+   for_chunks( n, chunks( n ), f );
+}
+
+}; // namespace quantity_parallel
+
+#endif // ifndef quantity_parallel_hpp
@@ -0,0 +1,191 @@
+// ==========================================================================
+//
+// quantity_record.hpp
+//
+// a record of named quantity fields, stored without avoidable padding
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_record_hpp
+#define quantity_record_hpp
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "quantity.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+
+// ==========================================================================
+//
+// field
+//
+// ==========================================================================
+
+/// a field of a quantity_record: a name (any type) and a quantity type
+template< typename Name, typename Q >
+struct quantity_field {
+
+   /// the name of the field
+   using name = Name;
+
+   /// the quantity type of the field
+   using quantity_type = quantity_implementation<
+      typename Q::value_type, typename Q::tags >;
+};
+
+
+// ==========================================================================
+//
+// record
+//
+// ==========================================================================
+
+/// record of named quantities, ordered in memory by alignment
+//
+/// Each of the Fields is a quantity_field< Name, Q >.
+/// The fields are accessed by name: record.get< Name >().
+///
+/// In a plain struct the fields are stored in the order of declaration,
+/// with padding before each field that is more aligned than
+/// the previous one.
+/// A quantity_record stores its fields in order of decreasing
+/// alignment, so the only padding is at the end, and its size is
+/// the sum of the field sizes rounded up to the largest alignment.
+/// A quantity_record is trivially copyable.
+template< typename... Fields >
+class quantity_record {
+private:
+
+   static_assert( sizeof...( Fields ) > 0, "a record needs a field" );
+
+   static constexpr std::size_t count = sizeof...( Fields );
+
+   static constexpr std::array< std::size_t, count > sizes {
+      sizeof( typename Fields::quantity_type )... };
+
+   static constexpr std::array< std::size_t, count > alignments {
+      alignof( typename Fields::quantity_type )... };
+
+   // offsets of the fields, in declaration order:
+   // repeatedly place the most aligned field that has not been placed
+   static constexpr std::array< std::size_t, count > place(){
+      std::array< std::size_t, count > offsets {};
+      std::array< bool, count > placed {};
+      std::size_t offset = 0;
+      for( std::size_t n = 0; n < count; ++n ){
+         std::size_t best = count;
+         for( std::size_t i = 0; i < count; ++i ){
+            if( ! placed[ i ]
+               && ( best == count || alignments[ i ] > alignments[ best ] )
+            ){
+               best = i;
+            }
+         }
+         placed[ best ] = true;
+         offsets[ best ] = offset;
+         offset += sizes[ best ];
+      }
+      return offsets;
+   }
+
+   static constexpr std::size_t largest_alignment(){
+      std::size_t a = 1;
+      for( auto x : alignments ){
+         a = x > a ? x : a;
+      }
+      return a;
+   }
+
+   static constexpr std::size_t total_size(){
+      std::size_t s = 0;
+      for( auto x : sizes ){
+         s += x;
+      }
+      return s;
+   }
+
+   // the index (in declaration order) of the field with name Name
+   template< typename Name >
+   static constexpr std::size_t index(){
+      constexpr bool match[] = {
+         std::is_same< Name, typename Fields::name >::value... };
+      std::size_t found = count;
+      for( std::size_t i = 0; i < count; ++i ){
+         if( match[ i ] ){
+            found = found == count ? i : count + 1;
+         }
+      }
+      return found;
+   }
+
+   template< typename Name >
+   using field = typename std::tuple_element<
+      index< Name >(), std::tuple< Fields... > >::type;
+
+public:
+
+   /// the offset of each field, in order of declaration
+   static constexpr std::array< std::size_t, count > offsets = place();
+
+   /// the alignment of the record: the largest field alignment
+   static constexpr std::size_t alignment = largest_alignment();
+
+   /// the smallest possible size of the record:
+   /// the sum of the field sizes, rounded up to the alignment
+   static constexpr std::size_t minimum_size =
+      ( total_size() + alignment - 1 ) / alignment * alignment;
+
+private:
+
+   alignas( alignment ) unsigned char storage[ minimum_size ];
+
+   template< std::size_t... I >
+   void create( std::index_sequence< I... > ){
+      ( new ( storage + offsets[ I ] )
+         typename Fields::quantity_type(
+            Fields::quantity_type::from_raw(
+               typename Fields::quantity_type::value_type() ) ), ... );
+   }
+
+public:
+
+   /// create a record with all fields equal to the default base value
+   quantity_record(){
+      create( std::index_sequence_for< Fields... >() );
+   }
+
+   /// the field with name Name
+   template< typename Name >
+   auto & get(){
+      static_assert( index< Name >() < count,
+         "the record must have exactly one field with this name" );
+      return * std::launder(
+         reinterpret_cast< typename field< Name >::quantity_type * >(
+            storage + offsets[ index< Name >() ] ) );
+   }
+
+   /// the field with name Name
+   template< typename Name >
+   const auto & get() const {
+      static_assert( index< Name >() < count,
+         "the record must have exactly one field with this name" );
+      return * std::launder(
+         reinterpret_cast< const typename field< Name >::quantity_type * >(
+            storage + offsets[ index< Name >() ] ) );
+   }
+};
+
+#endif // ifndef quantity_record_hpp
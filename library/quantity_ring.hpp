@@ -0,0 +1,162 @@
+// ==========================================================================
+//
+// quantity_ring.hpp
+//
+// a wait-free single-producer single-consumer ring buffer of quantities
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_ring_hpp
+#define quantity_ring_hpp
+
+#include <atomic>
+#include <cstddef>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+
+// ==========================================================================
+//
+// ring
+//
+// ==========================================================================
+
+/// ring buffer of Capacity quantity_implementation< V, T > values
+//
+/// One producer (for instance an interrupt handler) pushes,
+/// one consumer (for instance a task) pops.
+/// Each operation is wait-free: it does a fixed amount of work,
+/// without loops that depend on the other side.
+/// push() returns false when the ring is full,
+/// pop() returns false when it is empty.
+/// The batch versions push or pop as many values of a span
+/// as possible, and return that number.
+///
+/// Capacity must be a power of two.
+/// The values are stored in the object itself, so a ring
+/// can be a global or static object without any heap use.
+/// The producer and the consumer each write their own index,
+/// which is in a cache line of its own, next to the copy of the
+/// other index that they last saw.
+template< typename V, typename T, std::size_t Capacity >
+class quantity_ring {
+public:
+
+   static_assert( Capacity > 0 && ( Capacity & ( Capacity - 1 ) ) == 0,
+      "the capacity of a ring must be a power of two" );
+
+   /// the quantity type of the values
+   using quantity_type = quantity_implementation< V, T >;
+
+   /// the number of values the ring can hold
+   static constexpr std::size_t capacity = Capacity;
+
+private:
+
+   static constexpr std::size_t mask = Capacity - 1;
+
+   // producer side: the next position to write, the last seen head
+   alignas( 64 ) std::atomic< std::size_t > tail{ 0 };
+   std::size_t head_seen = 0;
+
+   // consumer side: the next position to read, the last seen tail
+   alignas( 64 ) std::atomic< std::size_t > head{ 0 };
+   std::size_t tail_seen = 0;
+
+   alignas( 64 ) V values[ Capacity ];
+
+   // the number of values the producer can write,
+   // head is read only when the last seen head leaves less than wanted
+   std::size_t writeable( std::size_t t, std::size_t wanted ){
+      if( Capacity - ( t - head_seen ) < wanted ){
+         head_seen = head.load( std::memory_order_acquire );
+      }
+      return Capacity - ( t - head_seen );
+   }
+
+   // the number of values the consumer can read,
+   // tail is read only when the last seen tail leaves less than wanted
+   std::size_t readable( std::size_t h, std::size_t wanted ){
+      if( tail_seen - h < wanted ){
+         tail_seen = tail.load( std::memory_order_acquire );
+      }
+      return tail_seen - h;
+   }
+
+public:
+
+   /// add a value, return false when the ring is full (producer only)
+   bool push( const quantity_type & q ){
+      const auto t = tail.load( std::memory_order_relaxed );
+      if( writeable( t, 1 ) == 0 ){
+         return false;
+      }
+      values[ t & mask ] = q.raw();
+      tail.store( t + 1, std::memory_order_release );
+      return true;
+   }
+
+   /// remove the oldest value, return false when the ring is empty
+   /// (consumer only)
+   bool pop( quantity_type & q ){
+      const auto h = head.load( std::memory_order_relaxed );
+      if( readable( h, 1 ) == 0 ){
+         return false;
+      }
+      q = quantity_type::from_raw( values[ h & mask ] );
+      head.store( h + 1, std::memory_order_release );
+      return true;
+   }
+
+   /// add values from a span, return the number that was added
+   /// (producer only)
+   std::size_t push( quantity_span< const quantity_type > in ){
+      const auto t = tail.load( std::memory_order_relaxed );
+      auto n = writeable( t, in.size() );
+      n = n < in.size() ? n : in.size();
+      const V * source = in.raw();
+      for( std::size_t i = 0; i < n; ++i ){
+         values[ ( t + i ) & mask ] = source[ i ];
+      }
+      tail.store( t + n, std::memory_order_release );
+      return n;
+   }
+
+   /// remove values into a span, return the number that was removed
+   /// (consumer only)
+   std::size_t pop( quantity_span< quantity_type > out ){
+      const auto h = head.load( std::memory_order_relaxed );
+      auto n = readable( h, out.size() );
+      n = n < out.size() ? n : out.size();
+      V * destination = out.raw();
+      for( std::size_t i = 0; i < n; ++i ){
+         destination[ i ] = values[ ( h + i ) & mask ];
+      }
+      head.store( h + n, std::memory_order_release );
+      return n;
+   }
+
+   /// the number of values in the ring (only exact when neither
+   /// side runs concurrently)
+   std::size_t size() const {
+      return tail.load( std::memory_order_acquire )
+         - head.load( std::memory_order_acquire );
+   }
+
+   /// whether the ring is empty (same restriction as size())
+   bool empty() const {
+      return size() == 0;
+   }
+};
+
+#endif // ifndef quantity_ring_hpp
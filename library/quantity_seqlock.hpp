@@ -0,0 +1,138 @@
+// ==========================================================================
+//
+// quantity_seqlock.hpp
+//
+// publication of a record of quantities to many readers, with a seqlock
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_seqlock_hpp
+#define quantity_seqlock_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "quantity.hpp"
+#include "quantity_record.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+
+// ==========================================================================
+//
+// seqlock
+//
+// ==========================================================================
+
+/// a quantity_record< Fields... > published by one writer to many readers
+//
+/// The writer publishes a new state with publish( record ).
+/// This is wait-free: it increments a sequence number (to an odd
+/// value), stores the record and increments the sequence number again.
+/// A reader reads the sequence number, the record and the sequence
+/// number again, and retries when it was odd or has changed.
+/// Readers never block the writer and don't write to shared memory,
+/// so any number of them can read concurrently.
+///
+/// The record is stored as an array of 64-bit atomic words,
+/// which are copied with relaxed loads and stores,
+/// so a read that overlaps a publish is not a data race.
+/// This requires the record to be trivially copyable,
+/// which a quantity_record of arithmetic base values is.
+template< typename... Fields >
+class quantity_seqlock {
+public:
+
+   /// the type of the published state
+   using record_type = quantity_record< Fields... >;
+
+   static_assert( std::is_trivially_copyable< record_type >::value,
+      "a seqlock requires a trivially copyable record" );
+
+private:
+
+   using word = std::uint64_t;
+
+   static constexpr std::size_t words =
+      ( sizeof( record_type ) + sizeof( word ) - 1 ) / sizeof( word );
+
+   alignas( 64 ) std::atomic< std::uint64_t > sequence{ 0 };
+   std::atomic< word > data[ words ];
+
+   static void to_words( const record_type & r, word * w ){
+      w[ words - 1 ] = 0;
+      std::memcpy( w, & r, sizeof( record_type ) );
+   }
+
+   static void from_words( const word * w, record_type & r ){
+      std::memcpy( static_cast< void * >( & r ), w, sizeof( record_type ) );
+   }
+
+public:
+
+   /// create a seqlock that holds a default record
+   quantity_seqlock(){
+      word w[ words ];
+      to_words( record_type(), w );
+      for( std::size_t i = 0; i < words; ++i ){
+         data[ i ].store( w[ i ], std::memory_order_relaxed );
+      }
+   }
+
+   quantity_seqlock( const quantity_seqlock & ) = delete;
+   quantity_seqlock & operator=( const quantity_seqlock & ) = delete;
+
+   /// publish a new state (one writer only)
+   void publish( const record_type & r ){
+      word w[ words ];
+      to_words( r, w );
+      const auto s = sequence.load( std::memory_order_relaxed );
+      sequence.store( s + 1, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_release );
+      for( std::size_t i = 0; i < words; ++i ){
+         data[ i ].store( w[ i ], std::memory_order_relaxed );
+      }
+      sequence.store( s + 2, std::memory_order_release );
+   }
+
+   /// try to read the state once, return false when a publish
+   /// overlapped the read (r is then not changed)
+   bool try_read( record_type & r ) const {
+      word w[ words ];
+      const auto before = sequence.load( std::memory_order_acquire );
+      for( std::size_t i = 0; i < words; ++i ){
+         w[ i ] = data[ i ].load( std::memory_order_relaxed );
+      }
+      std::atomic_thread_fence( std::memory_order_acquire );
+      const auto after = sequence.load( std::memory_order_relaxed );
+      if( before != after || ( before & 1 ) != 0 ){
+         return false;
+      }
+      from_words( w, r );
+      return true;
+   }
+
+   /// read a consistent state, retrying until no publish overlaps
+   record_type read() const {
+      record_type r;
+      while( ! try_read( r ) ){}
+      return r;
+   }
+
+   /// the number of publishes so far
+   std::uint64_t version() const {
+      return sequence.load( std::memory_order_acquire ) / 2;
+   }
+};
+
+#endif // ifndef quantity_seqlock_hpp
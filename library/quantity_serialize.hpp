@@ -0,0 +1,194 @@
+// ==========================================================================
+//
+// quantity_serialize.hpp
+//
+// binary serialization of quantities, tagged with the fingerprint
+// of their tag type
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_serialize_hpp
+#define quantity_serialize_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_serialize
+///
+/// The serialization functions write quantities as raw bytes,
+/// preceded by the 64-bit fingerprint of their tag type
+/// (type_multiset::fingerprint), and check that fingerprint when
+/// they read them back.
+/// The fingerprint is a compile-time constant, so the check is a
+/// single compare, without comparing the names of the tags.
+/// They live in the namespace quantity_serialize.
+///
+/// A single quantity is written as the fingerprint followed by its
+/// base value, a span as the fingerprint, the number of values
+/// (64 bits) and the base values.
+/// All are in the byte order of the host, and without alignment.
+/// The base type is not recorded: a value must be read
+/// with the base type it was written with.
+///
+/// The available functionality is:
+///
+/// size( quantity ), size( span )
+///    the number of bytes written for the quantity or span
+///
+/// write( p, quantity ), write( p, span )
+///    write to p, return the pointer after the written bytes
+///
+/// read( p, end, quantity ), read( p, end, span, n )
+///    read from p (but not beyond end), and advance p.
+///    For a span, n is set to the number of values,
+///    which must not be more than the size of the span.
+///    The result is error::none, error::wrong_dimension
+///    or error::too_short.
+//
+// ==========================================================================
+
+namespace quantity_serialize {
+
+/// the result of a read
+enum class error {
+   none,             ///< the value(s) were read
+   wrong_dimension,  ///< the fingerprint is not that of the tag type
+   too_short,        ///< the data ends too soon, or the span is too small
+};
+
+/// the fingerprint of the tag type of a quantity type Q
+template< typename Q >
+constexpr std::uint64_t fingerprint =
+   type_multiset::fingerprint< typename Q::tags >::value;
+
+///@cond INTERNAL
+template< typename X >
+unsigned char * put( unsigned char * p, const X & x ){
+   std::memcpy( p, & x, sizeof( X ) );
+   return p + sizeof( X );
+}
+
+template< typename X >
+X get( const unsigned char * & p ){
+   X x;
+   std::memcpy( & x, p, sizeof( X ) );
+   p += sizeof( X );
+   return x;
+}
+
+// check the fingerprint of Q and the available size
+template< typename Q >
+error check( const unsigned char * & p, const unsigned char * end,
+   std::size_t size
+){
+   if( std::size_t( end - p ) < size ){
+      return error::too_short;
+   }
+   if( get< std::uint64_t >( p ) != fingerprint< Q > ){
+      p -= sizeof( std::uint64_t );
+      return error::wrong_dimension;
+   }
+   return error::none;
+}
+///@endcond
+
+
+// ==========================================================================
+//
+// single quantities
+//
+// ==========================================================================
+
+/// the number of bytes written for a quantity
+template< typename V, typename T >
+constexpr std::size_t size( const quantity_implementation< V, T > & ){
+   return sizeof( std::uint64_t ) + sizeof( V );
+}
+
+/// write a quantity
+template< typename V, typename T >
+unsigned char * write(
+   unsigned char * p, const quantity_implementation< V, T > & q
+){
+   p = put( p, fingerprint< quantity_implementation< V, T > > );
+   return put( p, q.raw() );
+}
+
+/// read a quantity
+template< typename V, typename T >
+error read(
+   const unsigned char * & p, const unsigned char * end,
+   quantity_implementation< V, T > & q
+){
+   auto result = check< quantity_implementation< V, T > >( p, end, size( q ) );
+   if( result == error::none ){
+      q = quantity_implementation< V, T >::from_raw( get< V >( p ) );
+   }
+   return result;
+}
+
+
+// ==========================================================================
+//
+// spans
+//
+// ==========================================================================
+
+/// the number of bytes written for a span
+template< typename Q >
+std::size_t size( quantity_span< Q > values ){
+   return 2 * sizeof( std::uint64_t )
+      + values.size() * sizeof( typename Q::value_type );
+}
+
+/// write a span
+template< typename Q >
+unsigned char * write( unsigned char * p, quantity_span< Q > values ){
+   p = put( p, fingerprint< Q > );
+   p = put( p, std::uint64_t( values.size() ) );
+   const auto bytes = values.size() * sizeof( typename Q::value_type );
+   std::memcpy( p, values.raw(), bytes );
+   return p + bytes;
+}
+
+/// read a span
+template< typename Q >
+error read(
+   const unsigned char * & p, const unsigned char * end,
+   quantity_span< Q > values, std::size_t & n
+){
+   const auto start = p;
+   auto result = check< Q >( p, end, 2 * sizeof( std::uint64_t ) );
+   if( result != error::none ){
+      return result;
+   }
+   const auto count = get< std::uint64_t >( p );
+   const auto bytes = count * sizeof( typename Q::value_type );
+   if( count > values.size() || std::size_t( end - p ) < bytes ){
+      p = start;
+      return error::too_short;
+   }
+   std::memcpy( values.raw(), p, bytes );
+   p += bytes;
+   n = count;
+   return error::none;
+}
+
+}; // namespace quantity_serialize
+
+#endif // ifndef quantity_serialize_hpp
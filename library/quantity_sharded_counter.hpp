@@ -0,0 +1,152 @@
+// ==========================================================================
+//
+// quantity_sharded_counter.hpp
+//
+// a quantity that is accumulated by many threads, in per-thread shards
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_sharded_counter_hpp
+#define quantity_sharded_counter_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "quantity.hpp"
+#include "quantity_atomic.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+///@cond INTERNAL
+namespace quantity_sharding {
+
+// the assumed size of a cache line
+constexpr std::size_t cache_line = 64;
+
+// the number of the next thread that uses a sharded counter
+inline std::atomic< std::size_t > next_thread{ 0 };
+
+// the number of the current thread, assigned on first use
+inline std::size_t thread_number(){
+   thread_local const std::size_t number = next_thread++;
+   return number;
+}
+
+}; // namespace quantity_sharding
+///@endcond
+
+
+// ==========================================================================
+//
+// sharded counter
+//
+// ==========================================================================
+
+/// quantity_implementation< V, T > accumulated by many threads
+//
+/// A sharded counter has a number of shards (a power of two).
+/// Each shard is a quantity_atomic in a cache line of its own.
+/// Each thread adds to the shard of its own thread number
+/// (modulo the number of shards), with relaxed memory order, so as
+/// long as there are no more threads than shards, threads don't
+/// share cache lines.
+/// read() sums the shards into one quantity of the same type.
+///
+/// The default number of shards is the number of hardware threads,
+/// rounded up to a power of two.
+/// read() is not a snapshot: it sees some of the additions that
+/// run concurrently with it.
+template< typename V, typename T >
+class quantity_sharded_counter {
+public:
+
+   /// the quantity type of the value
+   using quantity_type = quantity_implementation< V, T >;
+
+private:
+
+   struct alignas( quantity_sharding::cache_line ) shard {
+      quantity_atomic< V, T > value;
+   };
+
+   std::vector< shard > shards;
+   std::size_t mask;
+
+   static std::size_t round_up( std::size_t n ){
+      std::size_t p = 1;
+      while( p < n ){
+         p *= 2;
+      }
+      return p;
+   }
+
+   shard & own(){
+      return shards[ quantity_sharding::thread_number() & mask ];
+   }
+
+public:
+
+   /// create a counter with value 0 and (at least) n shards
+   explicit quantity_sharded_counter(
+      std::size_t n = std::thread::hardware_concurrency()
+   ):
+      shards( round_up( n ) ), mask( round_up( n ) - 1 )
+   {}
+
+   quantity_sharded_counter( const quantity_sharded_counter & ) = delete;
+   quantity_sharded_counter & operator=(
+      const quantity_sharded_counter & ) = delete;
+
+   /// the number of shards
+   std::size_t size() const {
+      return shards.size();
+   }
+
+   /// add q
+   template< typename U >
+   ///@cond INTERNAL
+   requires type_multiset::equal< T, U >::value
+   ///@endcond
+   void add( const quantity_implementation< V, U > & q ){
+      own().value.fetch_add( q, std::memory_order_relaxed );
+   }
+
+   /// subtract q
+   template< typename U >
+   ///@cond INTERNAL
+   requires type_multiset::equal< T, U >::value
+   ///@endcond
+   void sub( const quantity_implementation< V, U > & q ){
+      own().value.fetch_sub( q, std::memory_order_relaxed );
+   }
+
+   /// the sum of the shards
+   quantity_type read() const {
+      V sum = V( 0 );
+      for( const auto & s : shards ){
+         sum += s.value.load( std::memory_order_relaxed ).raw();
+      }
+      return quantity_type::from_raw( sum );
+   }
+
+   /// set all shards to 0
+   //
+   /// Additions that run concurrently with clear() may be lost.
+   void clear(){
+      for( auto & s : shards ){
+         s.value.store( quantity_type::from_raw( V( 0 ) ),
+            std::memory_order_relaxed );
+      }
+   }
+};
+
+#endif // ifndef quantity_sharded_counter_hpp
@@ -0,0 +1,302 @@
+// ==========================================================================
+//
+// quantity_shared_ring.hpp
+//
+// a lock-free ring buffer of quantities in POSIX shared memory,
+// for passing quantities between processes
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_shared_ring_hpp
+#define quantity_shared_ring_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+#include "quantity_file.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_shared_ring
+///
+/// A quantity_shared_ring< V, T > is a fixed-capacity queue of
+/// quantity_implementation< V, T > values in a POSIX shared memory
+/// segment (shm_open + mmap).
+/// One process creates the segment, any number of processes attach
+/// to it by name.
+/// Any number of them can push (multiple producers),
+/// only one of them may pop (single consumer).
+/// Push and pop don't block and don't take locks:
+/// push returns false when the ring is full, pop when it is empty.
+///
+/// The segment starts with a header that holds the base type code
+/// (as in quantity_file) and the fingerprint of the tag type
+/// (type_multiset::fingerprint).
+/// attach() checks these once, after that the ring is used through
+/// the static type of the quantity_shared_ring object.
+///
+/// The algorithm is the bounded queue of Dmitry Vyukov:
+/// each slot has a sequence number that tells whether it is free
+/// for the producer that claims its position, or filled for the
+/// consumer.
+//
+// ==========================================================================
+
+/// lock-free multiple-producer single-consumer ring of quantities
+/// in shared memory
+template< typename V, typename T >
+class quantity_shared_ring {
+public:
+
+   /// the quantity type of the values
+   using quantity_type = quantity_implementation< V, T >;
+
+   /// the result of create() and attach()
+   enum class error {
+      none,             ///< the ring can be used
+      cannot_open,      ///< the segment can't be created, opened or mapped
+      not_a_ring,       ///< the segment is not (yet) an initialized ring
+      wrong_value_type, ///< the ring holds values of another base type
+      wrong_dimension,  ///< the ring holds values of another tag type
+   };
+
+   static_assert( std::atomic< std::uint64_t >::is_always_lock_free,
+      "a shared ring requires lock-free 64-bit atomics" );
+
+private:
+
+   static constexpr std::uint64_t magic = 0x474e495251545951; // "QYTQRING"
+
+   struct alignas( 64 ) header {
+      std::atomic< std::uint64_t >              ready;
+      std::uint64_t                             value_type;
+      std::uint64_t                             fingerprint;
+      std::uint64_t                             capacity;
+      alignas( 64 ) std::atomic< std::uint64_t > head;
+      alignas( 64 ) std::atomic< std::uint64_t > tail;
+   };
+
+   struct slot {
+      std::atomic< std::uint64_t > sequence;
+      V value;
+   };
+
+   void * base = MAP_FAILED;
+   std::size_t length = 0;
+   header * h = nullptr;
+   slot * slots = nullptr;
+   std::uint64_t mask = 0;
+
+   static std::size_t size_for( std::uint64_t capacity ){
+      return sizeof( header ) + capacity * sizeof( slot );
+   }
+
+   // whether a capacity (from a segment) is usable: a power of two,
+   // for which size_for() doesn't overflow
+   static bool valid_capacity( std::uint64_t capacity ){
+      return capacity != 0
+         && ( capacity & ( capacity - 1 ) ) == 0
+         && capacity <= ( SIZE_MAX - sizeof( header ) ) / sizeof( slot );
+   }
+
+   bool map( int fd, std::size_t size ){
+      base = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+      ::close( fd );
+      if( base == MAP_FAILED ){
+         return false;
+      }
+      length = size;
+      h = static_cast< header * >( base );
+      slots = reinterpret_cast< slot * >(
+         static_cast< char * >( base ) + sizeof( header ) );
+      return true;
+   }
+
+public:
+
+   quantity_shared_ring() = default;
+   quantity_shared_ring( const quantity_shared_ring & ) = delete;
+   quantity_shared_ring & operator=( const quantity_shared_ring & ) = delete;
+
+   ~quantity_shared_ring(){
+      detach();
+   }
+
+   /// create the segment name, for capacity values
+   //
+   /// The capacity must be a power of two.
+   /// The segment must not exist yet.
+   error create( const char * name, std::uint64_t capacity ){
+      detach();
+      if( ! valid_capacity( capacity ) ){
+         return error::not_a_ring;
+      }
+      const int fd = ::shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0600 );
+      if( fd < 0 ){
+         return error::cannot_open;
+      }
+
+      // the segment was created here, so remove it when it can't be used
+      if( ::ftruncate( fd, size_for( capacity ) ) != 0 ){
+         ::close( fd );
+         ::shm_unlink( name );
+         return error::cannot_open;
+      }
+      if( ! map( fd, size_for( capacity ) ) ){
+         ::shm_unlink( name );
+         return error::cannot_open;
+      }
+
+      new ( h ) header;
+      h->value_type  = quantity_file::value_type_code< V >();
+      h->fingerprint = type_multiset::fingerprint< T >::value;
+      h->capacity    = capacity;
+      h->head.store( 0, std::memory_order_relaxed );
+      h->tail.store( 0, std::memory_order_relaxed );
+      for( std::uint64_t i = 0; i < capacity; ++i ){
+         new ( & slots[ i ] ) slot;
+         slots[ i ].sequence.store( i, std::memory_order_relaxed );
+      }
+      mask = capacity - 1;
+
+      // attach() checks this last, after everything else is initialized
+      h->ready.store( magic, std::memory_order_release );
+      return error::none;
+   }
+
+   /// attach to the existing segment name
+   error attach( const char * name ){
+      detach();
+      const int fd = ::shm_open( name, O_RDWR, 0600 );
+      if( fd < 0 ){
+         return error::cannot_open;
+      }
+      struct stat s;
+      if( ::fstat( fd, & s ) != 0
+         || std::size_t( s.st_size ) < sizeof( header )
+      ){
+         ::close( fd );
+         return error::not_a_ring;
+      }
+      if( ! map( fd, s.st_size ) ){
+         return error::cannot_open;
+      }
+
+      auto result = error::none;
+      if( h->ready.load( std::memory_order_acquire ) != magic
+         || ! valid_capacity( h->capacity )
+         || length < size_for( h->capacity )
+      ){
+         result = error::not_a_ring;
+      } else if( h->value_type != quantity_file::value_type_code< V >() ){
+         result = error::wrong_value_type;
+      } else if( h->fingerprint != type_multiset::fingerprint< T >::value ){
+         result = error::wrong_dimension;
+      }
+      if( result != error::none ){
+         detach();
+         return result;
+      }
+      mask = h->capacity - 1;
+      return error::none;
+   }
+
+   /// unmap the segment (it continues to exist)
+   void detach(){
+      if( base != MAP_FAILED ){
+         ::munmap( base, length );
+      }
+      base = MAP_FAILED;
+      length = 0;
+      h = nullptr;
+      slots = nullptr;
+      mask = 0;
+   }
+
+   /// remove the segment name (mapped segments continue to exist)
+   static void remove( const char * name ){
+      ::shm_unlink( name );
+   }
+
+   /// the number of values the ring can hold (0 when not attached)
+   std::uint64_t capacity() const {
+      return h == nullptr ? 0 : mask + 1;
+   }
+
+   /// add a value, return false when the ring is full
+   //
+   /// Any number of threads and processes can push concurrently.
+   bool push( const quantity_type & q ){
+      auto pos = h->head.load( std::memory_order_relaxed );
+      for(;;){
+         auto & s = slots[ pos & mask ];
+         const auto sequence = s.sequence.load( std::memory_order_acquire );
+         const auto difference = std::int64_t( sequence - pos );
+         if( difference == 0 ){
+            if( h->head.compare_exchange_weak(
+               pos, pos + 1, std::memory_order_relaxed )
+            ){
+               s.value = q.raw();
+               s.sequence.store( pos + 1, std::memory_order_release );
+               return true;
+            }
+         } else if( difference < 0 ){
+            return false;
+         } else {
+            pos = h->head.load( std::memory_order_relaxed );
+         }
+      }
+   }
+
+   /// remove the oldest value, return false when the ring is empty
+   //
+   /// Only one thread (in one process) may pop.
+   bool pop( quantity_type & q ){
+      const auto pos = h->tail.load( std::memory_order_relaxed );
+      auto & s = slots[ pos & mask ];
+      if( s.sequence.load( std::memory_order_acquire ) != pos + 1 ){
+         return false;
+      }
+      q = quantity_type::from_raw( s.value );
+      s.sequence.store( pos + mask + 1, std::memory_order_release );
+      h->tail.store( pos + 1, std::memory_order_relaxed );
+      return true;
+   }
+
+   /// push the values of a span, return the number that were pushed
+   std::size_t push( quantity_span< const quantity_type > values ){
+      std::size_t n = 0;
+      while( n < values.size() && push( values[ n ] ) ){
+         ++n;
+      }
+      return n;
+   }
+
+   /// pop values into a span, return the number that were popped
+   std::size_t pop( quantity_span< quantity_type > values ){
+      std::size_t n = 0;
+      while( n < values.size() && pop( values[ n ] ) ){
+         ++n;
+      }
+      return n;
+   }
+};
+
+#endif // ifndef quantity_shared_ring_hpp
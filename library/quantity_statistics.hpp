@@ -0,0 +1,280 @@
+// ==========================================================================
+//
+// quantity_statistics.hpp
+//
+// streaming mean, variance, minimum and maximum of quantities
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_statistics_hpp
+#define quantity_statistics_hpp
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+#include "quantity_parallel.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+
+// ==========================================================================
+//
+// statistics
+//
+// ==========================================================================
+
+/// streaming statistics of quantity_implementation< V, T > samples
+//
+/// The statistics are updated with each sample (Welford's method),
+/// or with each span of samples, without storing the samples.
+/// The results have the tag types that belong to them:
+/// the mean, the standard deviation, the minimum and the maximum
+/// have the tag type T, the variance has the tag type
+/// type_multiset::add< T, T >.
+///
+/// The mean and the variance are computed in the floating point type
+/// std::common_type< V, double > (double for integer samples).
+/// The statistics of two sets of samples can be merged (Chan's
+/// method), so each thread can collect its own statistics.
+/// add( policy, span ) does that with the quantity_parallel threads.
+///
+/// A span is handled in blocks: for each block the sum, the minimum
+/// and the maximum are computed first, and then the sum of the squared
+/// differences with the mean of the block, in plain loops that
+/// the compiler can vectorize.
+/// The statistics of the block are then merged.
+template< typename V, typename T >
+class quantity_statistics {
+public:
+
+   /// the quantity type of the samples
+   using quantity_type = quantity_implementation< V, T >;
+
+   /// the base type of the mean and the variance
+   using result_value_type = typename std::common_type< V, double >::type;
+
+   /// the quantity type of the mean and the standard deviation
+   using mean_type = quantity_implementation< result_value_type, T >;
+
+   /// the quantity type of the variance
+   using variance_type = quantity_implementation<
+      result_value_type, type_multiset::add< T, T > >;
+
+private:
+
+   // merge() reads the state of statistics of an equal tag type
+   template< typename, typename > friend class quantity_statistics;
+
+   using S = result_value_type;
+
+   // the number of samples of a block, and the number of
+   // independent sums in the loops over a block
+   static constexpr std::size_t block = 1024;
+   static constexpr std::size_t lanes = 8;
+
+   std::uint64_t n = 0;
+   S average = S( 0 );
+   S m2 = S( 0 );
+   V low = V( 0 );
+   V high = V( 0 );
+
+   // merge the statistics of k samples
+   void merge( std::uint64_t k, S k_average, S k_m2, V k_low, V k_high ){
+      if( k == 0 ){
+         return;
+      }
+      if( n == 0 ){
+         n = k;
+         average = k_average;
+         m2 = k_m2;
+         low = k_low;
+         high = k_high;
+         return;
+      }
+      const auto total = n + k;
+      const S delta = k_average - average;
+      average += delta * ( S( k ) / S( total ) );
+      m2 += k_m2 + delta * delta * ( S( n ) * S( k ) / S( total ) );
+      n = total;
+      low = k_low < low ? k_low : low;
+      high = high < k_high ? k_high : high;
+   }
+
+   // add the samples of one block ( 0 < size <= block )
+   void add_block( const V * __restrict__ p, std::size_t size ){
+      S sums[ lanes ] = {};
+      V mins[ lanes ], maxs[ lanes ];
+      for( std::size_t j = 0; j < lanes; ++j ){
+         mins[ j ] = maxs[ j ] = p[ 0 ];
+      }
+      const auto whole = size - size % lanes;
+      for( std::size_t i = 0; i < whole; i += lanes ){
+         for( std::size_t j = 0; j < lanes; ++j ){
+            const V x = p[ i + j ];
+            sums[ j ] += S( x );
+            mins[ j ] = x < mins[ j ] ? x : mins[ j ];
+            maxs[ j ] = maxs[ j ] < x ? x : maxs[ j ];
+         }
+      }
+      for( std::size_t i = whole; i < size; ++i ){
+         const V x = p[ i ];
+         sums[ 0 ] += S( x );
+         mins[ 0 ] = x < mins[ 0 ] ? x : mins[ 0 ];
+         maxs[ 0 ] = maxs[ 0 ] < x ? x : maxs[ 0 ];
+      }
+      S sum = S( 0 );
+      V b_low = mins[ 0 ], b_high = maxs[ 0 ];
+      for( std::size_t j = 0; j < lanes; ++j ){
+         sum += sums[ j ];
+         b_low = mins[ j ] < b_low ? mins[ j ] : b_low;
+         b_high = b_high < maxs[ j ] ? maxs[ j ] : b_high;
+      }
+      const S b_average = sum / S( size );
+
+      // the block is still in the cache for the second pass
+      S squares[ lanes ] = {};
+      for( std::size_t i = 0; i < whole; i += lanes ){
+         for( std::size_t j = 0; j < lanes; ++j ){
+            const S d = S( p[ i + j ] ) - b_average;
+            squares[ j ] += d * d;
+         }
+      }
+      for( std::size_t i = whole; i < size; ++i ){
+         const S d = S( p[ i ] ) - b_average;
+         squares[ 0 ] += d * d;
+      }
+      S b_m2 = S( 0 );
+      for( std::size_t j = 0; j < lanes; ++j ){
+         b_m2 += squares[ j ];
+      }
+      merge( size, b_average, b_m2, b_low, b_high );
+   }
+
+   // add size samples
+   void add_raw( const V * p, std::size_t size ){
+      for( std::size_t i = 0; i < size; i += block ){
+         add_block( p + i, size - i < block ? size - i : block );
+      }
+   }
+
+public:
+
+   /// create statistics of no samples
+   quantity_statistics() = default;
+
+   /// add a sample
+   template< typename U >
+   ///@cond INTERNAL
+   requires type_multiset::equal< T, U >::value
+   ///@endcond
+   void add( const quantity_implementation< V, U > & q ){
+      const V x = q.raw();
+      ++n;
+      const S delta = S( x ) - average;
+      average += delta / S( n );
+      m2 += delta * ( S( x ) - average );
+      if( n == 1 ){
+         low = high = x;
+      } else {
+         low = x < low ? x : low;
+         high = high < x ? x : high;
+      }
+   }
+
+   /// add the samples of a span
+   template< typename Q >
+   ///@cond INTERNAL
+   requires (
+      type_multiset::equal< T, typename quantity_span< Q >::tags >::value
+      && std::is_same< V, typename quantity_span< Q >::value_type >::value
+   )
+   ///@endcond
+   void add( quantity_span< Q > in ){
+      add_raw( in.raw(), in.size() );
+   }
+
+   /// add the samples of a span, split over threads by the policy
+   template< typename P, typename Q >
+   ///@cond INTERNAL
+   requires (
+      quantity_parallel::execution_policy< P >
+      && type_multiset::equal< T, typename quantity_span< Q >::tags >::value
+      && std::is_same< V, typename quantity_span< Q >::value_type >::value
+   )
+   ///@endcond
+   void add( P && policy, quantity_span< Q > in ){
+      const auto size = in.size();
+      const auto count = quantity_parallel::chunks( policy, size );
+      std::vector< quantity_statistics > partials( count );
+      quantity_parallel::for_chunks( size, count,
+         [ & ]( std::size_t c, std::size_t begin, std::size_t end ){
+            partials[ c ].add_raw( in.raw() + begin, end - begin );
+         } );
+      for( const auto & p : partials ){
+         merge( p );
+      }
+   }
+
+   /// add the samples of other (for instance of another thread)
+   template< typename U >
+   ///@cond INTERNAL
+   requires type_multiset::equal< T, U >::value
+   ///@endcond
+   void merge( const quantity_statistics< V, U > & other ){
+      merge( other.n, other.average, other.m2, other.low, other.high );
+   }
+
+   /// remove all samples
+   void clear(){
+      *this = quantity_statistics();
+   }
+
+   /// the number of samples
+   std::uint64_t count() const {
+      return n;
+   }
+
+   /// the mean of the samples (0 when there are none)
+   mean_type mean() const {
+      return mean_type::from_raw( average );
+   }
+
+   /// the (population) variance of the samples (0 when there are none)
+   variance_type variance() const {
+      return variance_type::from_raw( n == 0 ? S( 0 ) : m2 / S( n ) );
+   }
+
+   /// the sample variance (with n - 1), 0 when there are less than 2
+   variance_type sample_variance() const {
+      return variance_type::from_raw( n < 2 ? S( 0 ) : m2 / S( n - 1 ) );
+   }
+
+   /// the (population) standard deviation of the samples
+   mean_type standard_deviation() const {
+      return mean_type::from_raw( std::sqrt( variance().raw() ) );
+   }
+
+   /// the smallest sample (0 when there are none)
+   quantity_type min() const {
+      return quantity_type::from_raw( low );
+   }
+
+   /// the largest sample (0 when there are none)
+   quantity_type max() const {
+      return quantity_type::from_raw( high );
+   }
+};
+
+#endif // ifndef quantity_statistics_hpp
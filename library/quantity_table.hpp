@@ -0,0 +1,162 @@
+// ==========================================================================
+//
+// quantity_table.hpp
+//
+// a table of records of quantities, stored column-wise
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_table_hpp
+#define quantity_table_hpp
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "quantity.hpp"
+#include "quantity_array.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+
+// ==========================================================================
+//
+// quantity table
+//
+// ==========================================================================
+
+/// table of records, stored as one quantity_array per field
+//
+/// Each of the Columns is a quantity type, the I-th field of a row
+/// is a quantity_implementation with the base type and tag type
+/// of the I-th column.
+///
+/// Each column is stored contiguously, so a scan over one field
+/// only touches the memory of that field.
+/// column< I >() returns the I-th column as a span,
+/// which can be used with the quantity algorithms and expressions.
+/// A row is accessed through a proxy: table[ i ].get< I >()
+/// is (a reference to) the I-th field of row i.
+template< typename... Columns >
+class quantity_table {
+public:
+
+   /// the number of columns
+   static constexpr std::size_t columns = sizeof...( Columns );
+
+   /// the quantity type of column I
+   template< std::size_t I >
+   using column_type = quantity_implementation<
+      typename std::tuple_element< I, std::tuple< Columns... > >::type
+         ::value_type,
+      typename std::tuple_element< I, std::tuple< Columns... > >::type
+         ::tags >;
+
+private:
+
+   std::tuple< quantity_array<
+      typename Columns::value_type, typename Columns::tags >... > data;
+
+   template< std::size_t... I >
+   void resize_columns( std::size_t n, std::index_sequence< I... > ){
+      ( std::get< I >( data ).resize( n ), ... );
+   }
+
+   template< std::size_t... I >
+   void reserve_columns( std::size_t n, std::index_sequence< I... > ){
+      ( std::get< I >( data ).reserve( n ), ... );
+   }
+
+   template< typename Row, std::size_t... I >
+   void push_back_fields( const Row & row, std::index_sequence< I... > ){
+      ( std::get< I >( data ).push_back( std::get< I >( row ) ), ... );
+   }
+
+public:
+
+   /// a row: access to the fields of one record
+   template< typename Table >
+   class row_proxy {
+   private:
+      Table * table;
+      std::size_t i;
+
+   public:
+      row_proxy( Table * table, std::size_t i ):
+         table( table ), i( i )
+      {}
+
+      /// the I-th field of the row
+      template< std::size_t I >
+      auto & get() const {
+         return table->template column< I >()[ i ];
+      }
+   };
+
+   /// create an empty table
+   quantity_table()
+   {}
+
+   /// create a table of n rows
+   explicit quantity_table( std::size_t n ){
+      resize( n );
+   }
+
+   /// the number of rows
+   std::size_t size() const {
+      return std::get< 0 >( data ).size();
+   }
+
+   /// change the number of rows
+   void resize( std::size_t n ){
+      resize_columns( n, std::index_sequence_for< Columns... >() );
+   }
+
+   /// reserve memory for at least n rows
+   void reserve( std::size_t n ){
+      reserve_columns( n, std::index_sequence_for< Columns... >() );
+   }
+
+   /// append a row, one quantity per column
+   template< typename... Fields >
+   ///@cond INTERNAL
+   requires ( sizeof...( Fields ) == sizeof...( Columns ) )
+   ///@endcond
+   void push_back( const Fields &... fields ){
+      push_back_fields(
+         std::forward_as_tuple( fields... ),
+         std::index_sequence_for< Columns... >() );
+   }
+
+   /// column I, as a writeable span
+   template< std::size_t I >
+   quantity_span< column_type< I > > column(){
+      return std::get< I >( data ).span();
+   }
+
+   /// column I, as a read-only span
+   template< std::size_t I >
+   quantity_span< const column_type< I > > column() const {
+      return std::get< I >( data ).span();
+   }
+
+   /// row i (not range-checked)
+   row_proxy< quantity_table > operator[]( std::size_t i ){
+      return row_proxy< quantity_table >( this, i );
+   }
+
+   /// row i (not range-checked), read-only
+   row_proxy< const quantity_table > operator[]( std::size_t i ) const {
+      return row_proxy< const quantity_table >( this, i );
+   }
+};
+
+#endif // ifndef quantity_table_hpp
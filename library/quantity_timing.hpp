@@ -0,0 +1,468 @@
+// ==========================================================================
+//
+// quantity_timing.hpp
+//
+// scope timers that produce typed durations, with per-stage histograms
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#ifndef quantity_timing_hpp
+#define quantity_timing_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <ratio>
+#include <vector>
+#include "quantity.hpp"
+#include "quantity_atomic.hpp"
+
+// this file contains Doxygen lines
+/// @file
+
+// ==========================================================================
+//
+/// \page quantity_timing
+///
+/// Timing measures how long stages of a program take, as typed
+/// durations: quantity_timing::duration is a quantity of
+/// std::int64_t nanoseconds (tag quantity_timing::ns), so a duration
+/// can't be mixed up with a plain number, or with another quantity.
+/// It lives in the namespace quantity_timing.
+///
+/// A stage is a static quantity_timing::stage object with a name.
+/// A quantity_timing::scope object times its own lifetime
+/// and adds that duration to the histogram of its stage:
+///
+///    static quantity_timing::stage parse( "parse" );
+///    ...
+///    {
+///       quantity_timing::scope timer( parse );
+///       ...
+///    }
+///
+/// The clock is std::chrono::steady_clock (clock_gettime, which
+/// Linux runs without a system call), read once at the start and
+/// once at the end of a scope.
+/// Each thread adds to its own block of the histogram of a stage,
+/// with relaxed atomic loads and stores, so timing doesn't lock,
+/// doesn't use read-modify-write operations,
+/// and threads don't share cache lines.
+///
+/// A histogram has a bucket for each power of two nanoseconds, and
+/// the count, the total, the minimum and the maximum of the durations.
+/// report< Unit >( file ) writes a line per stage with its count and
+/// its mean, minimum, median, 99th percentile and maximum duration,
+/// in the std::chrono duration Unit (default std::chrono::microseconds).
+/// to_chrono< Unit >( d ) and from_chrono( d ) convert between
+/// durations and std::chrono durations of any unit.
+//
+// ==========================================================================
+
+namespace quantity_timing {
+
+/// the tag of durations: nanoseconds
+struct ns_tag {
+   static constexpr const char * name = "ns";
+};
+
+/// the tag type (type multiset) of durations
+using ns = type_multiset::one< ns_tag >;
+
+/// a duration in nanoseconds
+using duration = quantity_implementation< std::int64_t, ns >;
+
+/// the current time, as a duration since the start of the clock
+inline duration now(){
+   return duration::from_raw(
+      std::chrono::duration_cast< std::chrono::nanoseconds >(
+         std::chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+/// the duration d as a std::chrono duration of type Unit (truncated)
+template< typename Unit >
+Unit to_chrono( const duration & d ){
+   return std::chrono::duration_cast< Unit >(
+      std::chrono::nanoseconds( d.raw() ) );
+}
+
+/// the std::chrono duration d as a duration (truncated to ns)
+template< typename Rep, typename Period >
+duration from_chrono( const std::chrono::duration< Rep, Period > & d ){
+   return duration::from_raw(
+      std::chrono::duration_cast< std::chrono::nanoseconds >( d ).count() );
+}
+
+/// the number of buckets of a histogram
+constexpr std::size_t buckets = 64;
+
+/// the contents of a histogram
+//
+/// Bucket 0 counts the durations of 0 ns (or less),
+/// bucket i > 0 those from 2^(i-1) ns up to 2^i ns.
+struct summary {
+
+   /// the number of durations
+   std::uint64_t count = 0;
+
+   /// the sum of the durations
+   duration total = duration::from_raw( 0 );
+
+   /// the shortest duration (0 when there are none)
+   duration min = duration::from_raw( 0 );
+
+   /// the longest duration (0 when there are none)
+   duration max = duration::from_raw( 0 );
+
+   /// the number of durations in each bucket
+   std::uint64_t bucket[ buckets ] = {};
+
+   /// the mean duration (0 when there are none)
+   duration mean() const {
+      return count == 0
+         ? duration::from_raw( 0 )
+         : duration::from_raw( total.raw() / std::int64_t( count ) );
+   }
+
+   /// an upper bound of the p (0..1) quantile
+   //
+   /// This is the upper end of the bucket that contains the
+   /// quantile, limited by max, so it is at most twice the quantile.
+   duration percentile( double p ) const {
+      const auto wanted = std::uint64_t( p * count );
+      std::uint64_t seen = 0;
+      for( std::size_t i = 0; i < buckets; ++i ){
+         seen += bucket[ i ];
+         if( seen > wanted || seen == count ){
+            const auto top = std::int64_t( ( std::uint64_t( 1 ) << i ) - 1 );
+            return top < max.raw() ? duration::from_raw( top ) : max;
+         }
+      }
+      return max;
+   }
+};
+
+///@cond INTERNAL
+
+// the number of the next histogram
+inline std::atomic< std::size_t > next_histogram{ 0 };
+
+///@endcond
+
+/// a histogram of durations, added to by many threads
+//
+/// Each thread that adds to a histogram gets a block of its own,
+/// which only that thread writes (with relaxed atomic loads and
+/// stores, no read-modify-write operations).
+/// read() sums the blocks of all threads.
+/// The blocks remain part of the histogram when their thread ends.
+class histogram {
+private:
+
+   struct alignas( 64 ) block {
+      std::atomic< std::uint64_t > count;
+      quantity_atomic< std::int64_t, ns > total;
+      quantity_atomic< std::int64_t, ns > min;
+      quantity_atomic< std::int64_t, ns > max;
+      std::atomic< std::uint64_t > bucket[ buckets ];
+      block * next = nullptr;
+
+      block(){
+         clear();
+      }
+
+      void clear(){
+         count.store( 0, std::memory_order_relaxed );
+         total.store( duration::from_raw( 0 ), std::memory_order_relaxed );
+         min.store( duration::from_raw(
+            std::numeric_limits< std::int64_t >::max() ),
+            std::memory_order_relaxed );
+         max.store( duration::from_raw(
+            std::numeric_limits< std::int64_t >::min() ),
+            std::memory_order_relaxed );
+         for( auto & b : bucket ){
+            b.store( 0, std::memory_order_relaxed );
+         }
+      }
+   };
+
+   // the blocks of all threads, a list to which blocks are only added
+   std::atomic< block * > blocks{ nullptr };
+
+   // the number of the histogram, indexes the blocks of a thread
+   const std::size_t number = next_histogram++;
+
+   // the blocks of the calling thread, indexed by histogram number
+   static std::vector< block * > & own_blocks(){
+      thread_local std::vector< block * > own;
+      return own;
+   }
+
+   block & own(){
+      auto & own = own_blocks();
+      if( number < own.size() && own[ number ] != nullptr ){
+         return *own[ number ];
+      }
+      if( own.size() <= number ){
+         own.resize( number + 1, nullptr );
+      }
+      auto b = new block;
+      b->next = blocks.load( std::memory_order_relaxed );
+      while( ! blocks.compare_exchange_weak(
+         b->next, b, std::memory_order_release, std::memory_order_relaxed ) ){}
+      own[ number ] = b;
+      return *b;
+   }
+
+   // the bucket of a duration of n ns: the number of bits of n
+   static std::size_t bucket_of( std::int64_t n ){
+      if( n <= 0 ){
+         return 0;
+      }
+      const std::size_t bits = 64 - __builtin_clzll( std::uint64_t( n ) );
+      return bits < buckets ? bits : buckets - 1;
+   }
+
+   // add 1 to a counter that only the calling thread writes
+   static void increment( std::atomic< std::uint64_t > & n ){
+      n.store( n.load( std::memory_order_relaxed ) + 1,
+         std::memory_order_relaxed );
+   }
+
+public:
+
+   /// create an empty histogram
+   histogram() = default;
+
+   histogram( const histogram & ) = delete;
+   histogram & operator=( const histogram & ) = delete;
+
+   ~histogram(){
+      auto b = blocks.load( std::memory_order_acquire );
+      while( b != nullptr ){
+         auto next = b->next;
+         delete b;
+         b = next;
+      }
+   }
+
+   /// add a duration
+   void add( const duration & d ){
+      auto & b = own();
+      increment( b.count );
+      increment( b.bucket[ bucket_of( d.raw() ) ] );
+      b.total.store( b.total.load( std::memory_order_relaxed ) + d,
+         std::memory_order_relaxed );
+      if( d < b.min.load( std::memory_order_relaxed ) ){
+         b.min.store( d, std::memory_order_relaxed );
+      }
+      if( d > b.max.load( std::memory_order_relaxed ) ){
+         b.max.store( d, std::memory_order_relaxed );
+      }
+   }
+
+   /// the sum of the blocks of all threads
+   //
+   /// This is not a snapshot: it sees some of the durations
+   /// that are added concurrently.
+   summary read() const {
+      summary r;
+      auto low = std::numeric_limits< std::int64_t >::max();
+      auto high = std::numeric_limits< std::int64_t >::min();
+      std::int64_t total = 0;
+      for(
+         auto b = blocks.load( std::memory_order_acquire );
+         b != nullptr;
+         b = b->next
+      ){
+         r.count += b->count.load( std::memory_order_relaxed );
+         total += b->total.load( std::memory_order_relaxed ).raw();
+         const auto b_min = b->min.load( std::memory_order_relaxed ).raw();
+         const auto b_max = b->max.load( std::memory_order_relaxed ).raw();
+         low = b_min < low ? b_min : low;
+         high = b_max > high ? b_max : high;
+         for( std::size_t i = 0; i < buckets; ++i ){
+            r.bucket[ i ] += b->bucket[ i ].load( std::memory_order_relaxed );
+         }
+      }
+      r.total = duration::from_raw( total );
+      if( r.count > 0 ){
+         r.min = duration::from_raw( low );
+         r.max = duration::from_raw( high );
+      }
+      return r;
+   }
+
+   /// remove all durations
+   //
+   /// Durations that are added concurrently with clear() may be lost,
+   /// or remain.
+   void clear(){
+      for(
+         auto b = blocks.load( std::memory_order_acquire );
+         b != nullptr;
+         b = b->next
+      ){
+         b->clear();
+      }
+   }
+};
+
+
+// ==========================================================================
+//
+// stage and scope
+//
+// ==========================================================================
+
+class stage;
+
+///@cond INTERNAL
+
+// all stages, in the order of their creation
+struct stages {
+   std::mutex lock;
+   std::vector< stage * > list;
+};
+
+inline stages & all_stages(){
+   static stages s;
+   return s;
+}
+
+///@endcond
+
+/// a named part of a program whose durations are collected
+//
+/// A stage registers itself for report(), for its lifetime,
+/// so it is normally a static or global object.
+class stage {
+public:
+
+   /// the name of the stage
+   const char * const name;
+
+   /// the durations of the stage
+   quantity_timing::histogram histogram;
+
+   /// create a stage, name must remain valid (a string literal)
+   explicit stage( const char * name ):
+      name( name )
+   {
+      auto & s = all_stages();
+      std::lock_guard< std::mutex > guard( s.lock );
+      s.list.push_back( this );
+   }
+
+   ~stage(){
+      auto & s = all_stages();
+      std::lock_guard< std::mutex > guard( s.lock );
+      s.list.erase( std::find( s.list.begin(), s.list.end(), this ) );
+   }
+
+   stage( const stage & ) = delete;
+   stage & operator=( const stage & ) = delete;
+
+   /// add a duration
+   void add( const duration & d ){
+      histogram.add( d );
+   }
+};
+
+/// times its own lifetime, and adds it to a stage
+class scope {
+private:
+
+   quantity_timing::stage & owner;
+   const duration start;
+
+public:
+
+   /// start timing for the stage s
+   explicit scope( quantity_timing::stage & s ):
+      owner( s ), start( now() )
+   {}
+
+   scope( const scope & ) = delete;
+   scope & operator=( const scope & ) = delete;
+
+   /// the time since the start of the scope
+   duration elapsed() const {
+      return now() - start;
+   }
+
+   /// stop timing, and add the duration to the stage
+   ~scope(){
+      owner.add( now() - start );
+   }
+};
+
+
+// ==========================================================================
+//
+// report
+//
+// ==========================================================================
+
+///@cond INTERNAL
+
+// the symbol of a std::chrono period
+template< typename Period >
+const char * unit_symbol(){
+   if( std::ratio_equal< Period, std::nano >::value ){
+      return "ns";
+   } else if( std::ratio_equal< Period, std::micro >::value ){
+      return "us";
+   } else if( std::ratio_equal< Period, std::milli >::value ){
+      return "ms";
+   } else if( std::ratio_equal< Period, std::ratio< 1 > >::value ){
+      return "s";
+   } else if( std::ratio_equal< Period, std::ratio< 60 > >::value ){
+      return "min";
+   }
+   return "?";
+}
+
+///@endcond
+
+/// write a summary line for each stage to file, in the unit Unit
+//
+/// Unit is a std::chrono duration type,
+/// the values are written with 3 decimals.
+template< typename Unit = std::chrono::microseconds >
+void report( std::FILE * file = stderr ){
+   using unit = std::chrono::duration< double, typename Unit::period >;
+   const auto symbol = unit_symbol< typename Unit::period >();
+   const auto in_unit = [ & ]( const duration & d ){
+      return to_chrono< unit >( d ).count();
+   };
+   std::fprintf( file, "%-20s %12s %12s %12s %12s %12s %12s  [%s]\n",
+      "stage", "count", "mean", "min", "p50", "p99", "max", symbol );
+   auto & s = all_stages();
+   std::lock_guard< std::mutex > guard( s.lock );
+   for( const auto p : s.list ){
+      const auto r = p->histogram.read();
+      std::fprintf( file,
+         "%-20s %12llu %12.3f %12.3f %12.3f %12.3f %12.3f\n",
+         p->name, (unsigned long long) r.count,
+         in_unit( r.mean() ), in_unit( r.min ),
+         in_unit( r.percentile( 0.5 ) ), in_unit( r.percentile( 0.99 ) ),
+         in_unit( r.max ) );
+   }
+}
+
+}; // namespace quantity_timing
+
+#endif // ifndef quantity_timing_hpp
@@ -62,6 +62,25 @@
 ///    in the type multiset A is the same in the type multiset B, 
 ///    and vice versa
 ///
+/// type_multiset::fingerprint< typename A >
+///    a 64-bit hash of the multiset, as a compile-time constant
+///    fingerprint< A >::value.
+///    It is computed from the name (a char or a string) and the 
+///    multiplicity of each element, and doesn't depend on the order 
+///    of the elements, so equal multisets have the same fingerprint.
+///    Different multisets will almost always have different fingerprints,
+///    unless they contain different types with the same name.
+///
+/// type_multiset::name_v< typename A >
+///    the name of the multiset, as a compile-time constant
+///    null-terminated char array.
+///    It contains, for each element, its name followed by its
+///    multiplicity (unless that is 1), like print() writes them,
+///    but with the elements ordered by name.
+///    Equal multisets hence have the same name, and share one array.
+///    This requires the names of the element types to be constexpr
+///    (a char or a const char *).
+///
 //
 // ==========================================================================
 
@@ -397,6 +416,254 @@ struct equal {
    static constexpr bool value = forward::value && backward::value;   
 };   
    
+
+
+// ===========================================================================
+//
+// fingerprint
+//
+// The fingerprint of each ( name, count ) pair is a (mixed) hash
+// of the name and the count. These are added, so the order of the
+// elements doesn't matter. Because equal elements are always merged
+// and elements with a count of 0 are always pruned, equal multisets
+// have the same pairs, and hence the same fingerprint.
+//
+// ===========================================================================
+
+// FNV-1a hash of a single-character name
+constexpr unsigned long long name_hash( char name ){
+   return ( 14695981039346656037ull ^ (unsigned char) name ) 
+      * 1099511628211ull;
+}
+
+// FNV-1a hash of a string name
+constexpr unsigned long long name_hash( const char * name ){
+   unsigned long long h = 14695981039346656037ull;
+   while( *name != '\0' ){
+      h = ( h ^ (unsigned char) *name++ ) * 1099511628211ull;
+   }
+   return h;
+}
+
+// FNV-1a hash of the name in [ first, last ),
+// equal to that of the same char or string name
+constexpr unsigned long long name_hash( const char * first, const char * last ){
+   unsigned long long h = 14695981039346656037ull;
+   while( first != last ){
+      h = ( h ^ (unsigned char) *first++ ) * 1099511628211ull;
+   }
+   return h;
+}
+
+// the splitmix64 finalizer: spreads the bits of a hash
+constexpr unsigned long long mix( unsigned long long x ){
+   x = ( x ^ ( x >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+   x = ( x ^ ( x >> 27 ) ) * 0x94d049bb133111ebull;
+   return x ^ ( x >> 31 );
+}
+
+// fingerprint recursor:
+// add the fingerprint of this pair to that of the tail
+template< typename Data, int Count, typename Tail >
+struct fingerprint_recursor {
+   static constexpr unsigned long long value =
+      mix( name_hash( Data::name ) ^ mix( (unsigned long long) Count ) )
+      + fingerprint_recursor< 
+         typename Tail::data, Tail::count, typename Tail::tail >::value;
+};
+
+// fingerprint recursion terminator: current element is the sentinel
+template<>
+struct fingerprint_recursor< void, 0, void > {
+   static constexpr unsigned long long value = 0;
+};
+
+// fingerprint interface:
+// unwrap the first element and call the recursor
+template< typename List >
+struct fingerprint {
+   static constexpr unsigned long long value = mix( 
+      fingerprint_recursor< 
+         typename List::data, List::count, typename List::tail >::value );
+};
+
+
+// ===========================================================================
+//
+// name
+//
+// The elements are first sorted by name into a canonical list of plain
+// nodes, so equal multisets have the same canonical list, and
+// hence share one name_text object.
+// The name_text object is filled by a constexpr function.
+//
+// ===========================================================================
+
+// the character at position i of a name (a char or a string), 
+// or '\0' beyond its end
+constexpr char name_at( char name, unsigned int i ){
+   return i == 0 ? name : '\0';
+}
+
+constexpr char name_at( const char * name, unsigned int i ){
+   return name[ i ];
+}
+
+// the number of characters of a name
+template< typename Name >
+constexpr unsigned int name_length( Name name ){
+   unsigned int n = 0;
+   while( name_at( name, n ) != '\0' ){
+      ++n;
+   }
+   return n;
+}
+
+// the number of characters of a count
+constexpr unsigned int count_length( int count ){
+   unsigned int n = count < 0 ? 2 : 1;
+   for( count /= 10; count != 0; count /= 10 ){
+      ++n;
+   }
+   return n;
+}
+
+// whether name a sorts before name b
+template< typename A, typename B >
+constexpr bool name_before( A a, B b ){
+   for( unsigned int i = 0; ; ++i ){
+      const auto x = (unsigned char) name_at( a, i );
+      const auto y = (unsigned char) name_at( b, i );
+      if( x != y ){
+         return x < y;
+      }
+      if( x == 0 ){
+         return false;
+      }
+   }
+}
+
+// whether an element goes before the element Other of a sorted list
+template< typename Data, typename Other >
+struct goes_before {
+   static constexpr bool value = name_before( Data::name, Other::name );
+};
+
+// an element goes before the sentinel
+template< typename Data >
+struct goes_before< Data, void > {
+   static constexpr bool value = true;
+};
+
+// insert recursor: insert an element in a sorted list
+template< typename Data, int Count, typename Sorted, bool Here >
+struct insert_sorted_recursor {
+   using type = node< 
+      typename Sorted::data, Sorted::count,
+      typename insert_sorted_recursor< 
+         Data, Count, typename Sorted::tail, 
+         goes_before< Data, typename Sorted::tail::data >::value
+      >::type >;
+};
+
+// insert recursor: the element goes here
+template< typename Data, int Count, typename Sorted >
+struct insert_sorted_recursor< Data, Count, Sorted, true > {
+   using type = node< Data, Count, Sorted >;
+};
+
+template< typename Data, int Count, typename Sorted >
+using insert_sorted = typename insert_sorted_recursor< 
+   Data, Count, Sorted, goes_before< Data, typename Sorted::data >::value
+>::type;
+
+// sort recursor: insert this element in the sorted tail
+template< typename Data, int Count, typename Tail >
+struct sort_recursor {
+   using type = insert_sorted< Data, Count, typename sort_recursor< 
+      typename Tail::data, Tail::count, typename Tail::tail >::type >;
+};
+
+// sort recursion terminator: current element is the sentinel
+template<>
+struct sort_recursor< void, 0, void > {
+   using type = sentinel;
+};
+
+// the multiset as a list of plain nodes, sorted by name
+template< typename List >
+using canonical = typename sort_recursor< 
+   typename List::data, List::count, typename List::tail >::type;
+
+// name recursor: the length and the characters of the name of a list
+template< typename Data, int Count, typename Tail >
+struct name_recursor {
+   using next = name_recursor< 
+      typename Tail::data, Tail::count, typename Tail::tail >;
+      
+   static constexpr unsigned int length = 
+      name_length( Data::name ) 
+      + ( Count == 1 ? 0 : count_length( Count ) )
+      + next::length;
+      
+   static constexpr void write( char * p ){
+      for( unsigned int i = 0; i < name_length( Data::name ); ++i ){
+         *p++ = name_at( Data::name, i );
+      }
+      if( Count != 1 ){
+         const auto n = count_length( Count );
+         auto c = Count < 0 ? - Count : Count;
+         for( unsigned int i = n; i > ( Count < 0 ? 1 : 0 ); --i ){
+            p[ i - 1 ] = char( '0' + c % 10 );
+            c /= 10;
+         }
+         if( Count < 0 ){
+            p[ 0 ] = '-';
+         }
+         p += n;
+      }
+      next::write( p );
+   }
+};
+
+// name recursion terminator: current element is the sentinel
+template<>
+struct name_recursor< void, 0, void > {
+   static constexpr unsigned int length = 0;
+   
+   static constexpr void write( char * p ){
+      *p = '\0';
+   }
+};
+
+// the name of a canonical list
+template< typename Canonical >
+struct name_text {
+   using recursor = name_recursor< 
+      typename Canonical::data, Canonical::count, 
+      typename Canonical::tail >;
+      
+   char data[ recursor::length + 1 ];
+   
+   static constexpr name_text make(){
+      name_text text = {};
+      recursor::write( text.data );
+      return text;
+   }
+};
+
+// the one name_text object of a canonical list
+template< typename Canonical >
+struct name_storage {
+   static constexpr name_text< Canonical > value = 
+      name_text< Canonical >::make();
+};
+
+// name interface:
+// the name of the canonical form of the list
+template< typename List >
+constexpr const auto & name_v = name_storage< canonical< List > >::value.data;
+
 } // namespace type_multiset
    
 ///@endcond // INTERNAL   
@@ -0,0 +1,782 @@
+// ==========================================================================
+//
+// test-benchmark.cpp
+//
+// timings of the concurrent and parallel parts of the library
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// This is not a test: it checks nothing, it prints timings.
+// It is run by make bench, which compiles it with optimization.
+// Waiting loops yield, so the timings are meaningful (but slow)
+// on a machine with fewer cores than threads.
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "quantity.hpp"
+#include "quantity_algorithms.hpp"
+#include "quantity_array.hpp"
+#include "quantity_atomic.hpp"
+#include "quantity_charconv.hpp"
+#include "quantity_codec.hpp"
+#include "quantity_csv.hpp"
+#include "quantity_file.hpp"
+#include "quantity_format.hpp"
+#include "quantity_log.hpp"
+#include "quantity_packed_array.hpp"
+#include "quantity_parallel.hpp"
+#include "quantity_ring.hpp"
+#include "quantity_seqlock.hpp"
+#include "quantity_sharded_counter.hpp"
+#include "quantity_table.hpp"
+#include "quantity_timing.hpp"
+
+struct tag_v { static constexpr const char * name = "V"; };
+
+using volt = quantity_implementation< double, type_multiset::one< tag_v > >;
+
+// the duration d in seconds
+double seconds( const quantity_timing::duration & d ){
+   return d.raw() * 1e-9;
+}
+
+// the results of timed code are added to this,
+// so that code isn't optimized away
+volatile double sink = 0;
+
+// the shortest time of three runs of f, in seconds
+template< typename F >
+double best_of_3( F f ){
+   double best = 0;
+   for( int run = 0; run < 3; ++run ){
+      const auto start = quantity_timing::now();
+      f();
+      const auto t = seconds( quantity_timing::now() - start );
+      best = run == 0 || t < best ? t : best;
+   }
+   return best;
+}
+
+
+
+// ==========================================================================
+//
+// parallel algorithms: the time of reduce, minmax and count_if
+// over 10^8 elements, for 1, 2, 4 ... threads
+//
+// ==========================================================================
+
+void bench_algorithms(){
+   const std::size_t n = 100'000'000;
+   quantity_array< double, type_multiset::one< tag_v > > x( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      x[ i ] = volt::from_raw( double( ( i * 37 ) % 1001 ) );
+   }
+   const auto threads = quantity_parallel::pool().threads();
+   for( std::size_t t = 1; ; t = t * 2 < threads ? t * 2 : threads ){
+      quantity_parallel::limit_threads( t );
+      const auto start = quantity_timing::now();
+      const auto sum = quantity_algorithms::reduce( 
+         quantity_parallel::par, x.span() );
+      const auto reduced = quantity_timing::now();
+      const auto mm = quantity_algorithms::minmax( 
+         quantity_parallel::par, x.span() );
+      const auto minmaxed = quantity_timing::now();
+      const auto k = quantity_algorithms::count_if( 
+         quantity_parallel::par, x.span(),
+         []( const volt & q ){ return q > volt::from_raw( 500.0 ); } );
+      const auto counted = quantity_timing::now();
+      std::printf( "10^8 values, %2zu threads: reduce %7.2f ms, "
+         "minmax %7.2f ms, count_if %7.2f ms\n",
+         t, seconds( reduced - start ) * 1e3, 
+         seconds( minmaxed - reduced ) * 1e3,
+         seconds( counted - minmaxed ) * 1e3 );
+      
+      // use the results, so they aren't optimized away
+      if( sum.raw() < 0 || mm.first > mm.second || k > n ){
+         std::printf( "wrong results\n" );
+      }
+      if( t == threads ){
+         break;
+      }
+   }
+   quantity_parallel::limit_threads( 0 );
+}
+
+
+
+// ==========================================================================
+//
+// table: a scan over one field of 10^7 rows of 4 fields,
+// stored column-wise and as an array of structs
+//
+// ==========================================================================
+
+void bench_table(){
+   const std::size_t n = 10'000'000;
+   quantity_table< volt, volt, volt, volt > table( n );
+   struct row { double a, b, c, d; };
+   std::vector< row > rows( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      table[ i ].get< 2 >() = volt::from_raw( i % 100 );
+      rows[ i ].c = i % 100;
+   }
+   const auto columns = best_of_3( [ & ](){
+      sink = sink + quantity_algorithms::reduce( 
+         quantity_parallel::seq, table.column< 2 >() ).raw();
+   } );
+   const auto structs = best_of_3( [ & ](){
+      double sum = 0;
+      for( const auto & r : rows ){
+         sum += r.c;
+      }
+      sink = sink + sum;
+   } );
+   std::printf( "table, sum of 1 of 4 fields: columns %7.2f ms, "
+      "array of structs %7.2f ms, %4.1fx\n",
+      columns * 1e3, structs * 1e3, structs / columns );
+}
+
+
+
+// ==========================================================================
+//
+// packed array: 10^7 12-bit values, packed and unpacked, and summed
+// from a plain array and from the packed array (read in blocks)
+//
+// ==========================================================================
+
+struct tag_adc { static constexpr const char * name = "adc"; };
+
+using adc = type_multiset::one< tag_adc >;
+using sample = quantity_implementation< std::uint16_t, adc >;
+
+// the sum of the base values of a span
+long long sum_of( quantity_span< const sample > in ){
+   long long sum = 0;
+   for( std::size_t i = 0; i < in.size(); ++i ){
+      sum += in.raw()[ i ];
+   }
+   return sum;
+}
+
+void bench_packed_array(){
+   const std::size_t n = 10'000'000, block = 4096;
+   quantity_array< std::uint16_t, adc > plain( n ), copy( n ), buffer( block );
+   for( std::size_t i = 0; i < n; ++i ){
+      plain[ i ] = sample::from_raw( ( i * 37 ) % 4096 );
+   }
+   quantity_packed_array< std::uint16_t, adc, 12 > packed;
+   const auto pack = best_of_3( [ & ](){ packed.pack( plain.span() ); } );
+   const auto unpack = best_of_3( [ & ](){ packed.unpack( copy.span() ); } );
+   const auto plain_sum = best_of_3( [ & ](){ 
+      sink = sink + sum_of( plain.span() ); 
+   } );
+   const auto unpacked_sum = best_of_3( [ & ](){
+      long long sum = 0;
+      for( std::size_t i = 0; i < n; i += block ){
+         const auto k = n - i < block ? n - i : block;
+         for( std::size_t j = 0; j < k; ++j ){
+            buffer[ j ] = packed[ i + j ];
+         }
+         sum += sum_of( buffer.span().subspan( 0, k ) );
+      }
+      sink = sink + sum;
+   } );
+   std::printf( "packed array, 12 of 16 bits: %zu instead of %zu bytes, "
+      "pack %7.1f M/s, unpack %7.1f M/s\n",
+      packed.bytes(), n * sizeof( std::uint16_t ),
+      n / pack * 1e-6, n / unpack * 1e-6 );
+   std::printf( "packed array, sum: plain %7.2f ms, get() %7.2f ms\n",
+      plain_sum * 1e3, unpacked_sum * 1e3 );
+}
+
+
+
+// ==========================================================================
+//
+// codec: encode and decode 10^7 slowly changing 32-bit values,
+// the GB/s of the values and the compression ratio
+//
+// ==========================================================================
+
+struct tag_mk { static constexpr const char * name = "mK"; };
+
+using mk = type_multiset::one< tag_mk >;
+using temperature = quantity_implementation< std::int32_t, mk >;
+
+void bench_codec(){
+   const std::size_t n = 10'000'000;
+   quantity_array< std::int32_t, mk > values( n ), decoded( n );
+   std::uint32_t noise = 1;
+   for( std::size_t i = 0; i < n; ++i ){
+      noise = noise * 1664525u + 1013904223u;
+      values[ i ] = temperature::from_raw( 
+         293'000 + std::int32_t( ( i / 1000 ) % 500 ) 
+         + std::int32_t( noise >> 29 ) - 4 );
+   }
+   std::size_t bytes = 0;
+   const auto encode = best_of_3( [ & ](){
+      quantity_codec::encoder< std::int32_t, mk > encoder;
+      encoder.write( values.span() );
+      encoder.flush();
+      bytes = encoder.data().size();
+   } );
+   quantity_codec::encoder< std::int32_t, mk > encoder;
+   encoder.write( values.span() );
+   encoder.flush();
+   const auto decode = best_of_3( [ & ](){
+      quantity_codec::decoder< std::int32_t, mk > decoder( 
+         encoder.data().data(), encoder.data().size() );
+      sink = sink + decoder.read( decoded.span() );
+   } );
+   const double size = n * sizeof( std::int32_t );
+   std::printf( "codec, 10^7 int32: encode %6.2f GB/s, decode %6.2f GB/s, "
+      "ratio %5.2f\n",
+      size / encode * 1e-9, size / decode * 1e-9, size / bytes );
+}
+
+
+
+// ==========================================================================
+//
+// quantity file: a query that selects 1 % of 10^8 rows,
+// as a full scan and using the zone map
+//
+// ==========================================================================
+
+void bench_file(){
+   const std::size_t n = 100'000'000, block = 1'000'000;
+   const char * path = "/tmp/test-benchmark.quantity";
+   {
+      quantity_file::writer< double, type_multiset::one< tag_v > > writer;
+      quantity_array< double, type_multiset::one< tag_v > > values( block );
+      writer.open( path );
+      for( std::size_t i = 0; i < n; i += block ){
+         for( std::size_t j = 0; j < block; ++j ){
+            values[ j ] = volt::from_raw( 
+               double( ( i + j ) / 1000 ) + double( ( j * 37 ) % 100 ) );
+         }
+         writer.write( values.span() );
+      }
+      writer.close();
+   }
+   quantity_file::reader< double, type_multiset::one< tag_v > > reader;
+   if( reader.open( path ) != quantity_file::error::none ){
+      std::printf( "quantity file: can't open %s\n", path );
+      return;
+   }
+   const auto c = quantity_file::greater( volt::from_raw( 0.99 * n / 1000 ) );
+   const auto scan = best_of_3( [ & ](){
+      const double * src = reader.span().raw();
+      std::size_t k = 0;
+      for( std::size_t i = 0; i < n; ++i ){
+         k += c.matches( src[ i ] ) ? 1 : 0;
+      }
+      sink = sink + k;
+   } );
+   const auto query = best_of_3( [ & ](){ sink = sink + reader.count( c ); } );
+   std::printf( "quantity file, 10^8 rows, count 1 %%: scan %7.2f ms, "
+      "zone map %7.2f ms, %5.1fx\n",
+      scan * 1e3, query * 1e3, scan / query );
+   reader.close();
+   std::remove( path );
+}
+
+
+
+// ==========================================================================
+//
+// charconv: 10^6 quantities written by to_chars,
+// and by the ostream path of operator<<, and read by from_chars,
+// with the suffix as to_chars writes it and spelled with spaces
+//
+// ==========================================================================
+
+void bench_charconv(){
+   const std::size_t n = 1'000'000;
+   quantity_array< double, type_multiset::one< tag_v > > values( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      values[ i ] = volt::from_raw( ( i * 37 ) % 1001 * 0.125 );
+   }
+   const auto chars = best_of_3( [ & ](){
+      char buffer[ 64 ];
+      std::size_t length = 0;
+      for( std::size_t i = 0; i < n; ++i ){
+         length += to_chars( buffer, buffer + sizeof( buffer ), values[ i ] )
+            .ptr - buffer;
+      }
+      sink = sink + length;
+   } );
+
+   // what operator<< does: a divide by one, the value, and the tags
+   const auto stream = best_of_3( [ & ](){
+      std::ostringstream s;
+      std::size_t length = 0;
+      for( std::size_t i = 0; i < n; ++i ){
+         s.str( "" );
+         s << values[ i ].raw() / volt::one.raw();
+         type_multiset::print< type_multiset::one< tag_v > >( s );
+         length += s.tellp();
+      }
+      sink = sink + length;
+   } );
+   std::printf( "charconv, 10^6 values: to_chars %6.1f ns, "
+      "ostream %6.1f ns, %4.1fx\n",
+      chars / n * 1e9, stream / n * 1e9, stream / chars );
+}
+
+struct tag_kg { static constexpr const char * name = "kg"; };
+struct tag_m { static constexpr const char * name = "m"; };
+struct tag_s { static constexpr const char * name = "s"; };
+
+using newton = type_multiset::add< 
+   type_multiset::one< tag_kg >, type_multiset::add< 
+      type_multiset::one< tag_m >, 
+      type_multiset::multiply< type_multiset::one< tag_s >, -2 > > >;
+using force = quantity_implementation< double, newton >;
+
+// the M quantities per second read from the lines of text
+double parses( const std::string & text ){
+   const auto t = best_of_3( [ & ](){
+      auto q = force::from_raw( 0 );
+      double sum = 0;
+      for( const char * p = text.data(), * end = p + text.size(); p != end; ){
+         p = from_chars( p, end, q ).ptr + 1;
+         sum += q.raw();
+      }
+      sink = sink + sum;
+   } );
+   std::size_t lines = 0;
+   for( const char c : text ){
+      lines += c == '\n' ? 1 : 0;
+   }
+   return lines / t * 1e-6;
+}
+
+void bench_from_chars(){
+   const std::size_t n = 1'000'000;
+   std::string compact, spaced;
+   char line[ 64 ];
+   for( std::size_t i = 0; i < n; ++i ){
+      const auto q = force::from_raw( ( i * 37 ) % 1001 * 0.125 );
+      auto end = to_chars( line, line + sizeof( line ), q ).ptr;
+      compact.append( line, end ).push_back( '\n' );
+      end = std::to_chars( line, line + sizeof( line ), q.raw() ).ptr;
+      spaced.append( line, end ).append( " kg m s^-2\n" );
+   }
+   std::printf( "from_chars, %s: %6.2f M/s, spaced: %6.2f M/s\n",
+      type_multiset::name_v< newton >, 
+      parses( compact ), parses( spaced ) );
+}
+
+
+
+// ==========================================================================
+//
+// format: 10^6 quantities written with 2 decimals in each unit style,
+// with std::format (when available), and with an ostream
+//
+// ==========================================================================
+
+template< typename F >
+void format_throughput( const char * what, std::size_t n, F f ){
+   const auto t = best_of_3( [ & ](){
+      std::size_t length = 0;
+      for( std::size_t i = 0; i < n; ++i ){
+         length += f( i );
+      }
+      sink = sink + length;
+   } );
+   std::printf( "format, %-10s %6.2f M values/s\n", what, n / t * 1e-6 );
+}
+
+void bench_format(){
+   const std::size_t n = 1'000'000;
+   quantity_array< double, type_multiset::one< tag_v > > values( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      values[ i ] = volt::from_raw( ( i * 37 ) % 1001 * 0.125 );
+   }
+   char buffer[ 64 ];
+   for( auto style : { 
+      quantity_format::unit::compact, 
+      quantity_format::unit::exponent, 
+      quantity_format::unit::none 
+   } ){
+      format_throughput( 
+         style == quantity_format::unit::compact ? "compact:" 
+            : style == quantity_format::unit::exponent ? "exponent:" 
+            : "none:", 
+         n, [ & ]( std::size_t i ){
+            return to_chars( buffer, buffer + sizeof( buffer ), values[ i ],
+               std::chars_format::fixed, 2, style ).ptr - buffer;
+         } );
+   }
+#ifdef __cpp_lib_format
+   format_throughput( "format:", n, [ & ]( std::size_t i ){
+      return std::format_to_n( 
+         buffer, sizeof( buffer ), "{:.2f}", values[ i ] ).size;
+   } );
+#endif
+   std::ostringstream s;
+   s << std::fixed << std::setprecision( 2 );
+   format_throughput( "ostream:", n, [ & ]( std::size_t i ){
+      s.str( "" );
+      s << values[ i ].raw();
+      type_multiset::print< type_multiset::one< tag_v > >( s );
+      return std::size_t( s.tellp() );
+   } );
+}
+
+
+
+// ==========================================================================
+//
+// CSV: parse 2 * 10^6 rows of 3 columns from memory,
+// MB/s in total and per thread, for 1, 2, 4 ... threads
+//
+// ==========================================================================
+
+void bench_csv(){
+   const std::size_t n = 2'000'000;
+   std::string text = "a[V],b[V],c[V]\n";
+   char line[ 64 ];
+   for( std::size_t i = 0; i < n; ++i ){
+      text.append( line, std::snprintf( line, sizeof( line ), 
+         "%zu,%.3f,%zu\n", i, ( i * 37 ) % 1001 * 0.125, i % 7 ) );
+   }
+   quantity_table< volt, volt, volt > table;
+   const auto mb = text.size() * 1e-6;
+   const auto threads = quantity_parallel::pool().threads();
+   for( std::size_t t = 1; ; t = t * 2 < threads ? t * 2 : threads ){
+      quantity_parallel::limit_threads( t );
+      const auto parse = best_of_3( [ & ](){
+         sink = sink + int( quantity_csv::parse( 
+            quantity_parallel::par, text.data(), text.size(), table ) );
+      } );
+      std::printf( "csv, %4.0f MB, %2zu threads: %7.1f MB/s, "
+         "%7.1f MB/s per thread\n",
+         mb, t, mb / parse, mb / parse / t );
+      if( t == threads ){
+         break;
+      }
+   }
+   quantity_parallel::limit_threads( 0 );
+}
+
+
+
+// ==========================================================================
+//
+// atomic: 10^7 additions to one quantity, spread over 1 .. 64 threads,
+// with fetch_add and with a mutex
+//
+// ==========================================================================
+
+struct tag_byte { static constexpr const char * name = "B"; };
+
+using byte_count = quantity_implementation< 
+   long long, type_multiset::one< tag_byte > >;
+
+// the M additions per second when each of the threads calls add() 
+template< typename F >
+double additions( int threads, F add ){
+   const long long total = 10'000'000;
+   std::vector< std::thread > workers;
+   const auto start = quantity_timing::now();
+   for( int i = 0; i < threads; ++i ){
+      workers.emplace_back( [ & ](){
+         for( long long k = 0; k < total / threads; ++k ){
+            add();
+         }
+      } );
+   }
+   for( auto & t : workers ){
+      t.join();
+   }
+   return total / seconds( quantity_timing::now() - start ) * 1e-6;
+}
+
+void bench_atomic(){
+   const auto byte = byte_count::from_raw( 1 );
+   for( int threads : { 1, 2, 4, 8, 16, 32, 64 } ){
+      quantity_atomic< long long, type_multiset::one< tag_byte > > atomic;
+      const auto atomic_rate = additions( threads, [ & ](){
+         atomic.fetch_add( byte, std::memory_order_relaxed );
+      } );
+      auto guarded = byte_count::from_raw( 0 );
+      std::mutex mutex;
+      const auto mutex_rate = additions( threads, [ & ](){
+         std::lock_guard< std::mutex > lock( mutex );
+         guarded = guarded + byte;
+      } );
+      sink = sink + atomic.load().raw() + guarded.raw();
+      std::printf( "atomic, %2d threads: fetch_add %7.2f M/s, "
+         "mutex %7.2f M/s\n",
+         threads, atomic_rate, mutex_rate );
+   }
+}
+
+
+
+// ==========================================================================
+//
+// sharded counter: 10^7 additions spread over 1 .. 64 threads,
+// to a sharded counter with 64 shards and to one atomic quantity
+//
+// ==========================================================================
+
+void bench_sharded_counter(){
+   const auto byte = byte_count::from_raw( 1 );
+   for( int threads : { 1, 2, 4, 8, 16, 32, 64 } ){
+      quantity_sharded_counter< long long, type_multiset::one< tag_byte > > 
+         sharded( 64 );
+      const auto sharded_rate = additions( threads, [ & ](){
+         sharded.add( byte );
+      } );
+      quantity_atomic< long long, type_multiset::one< tag_byte > > atomic;
+      const auto atomic_rate = additions( threads, [ & ](){
+         atomic.fetch_add( byte, std::memory_order_relaxed );
+      } );
+      sink = sink + sharded.read().raw() + atomic.load().raw();
+      std::printf( "sharded counter, %2d threads: sharded %7.2f M/s, "
+         "atomic %7.2f M/s\n",
+         threads, sharded_rate, atomic_rate );
+   }
+}
+
+
+
+// ==========================================================================
+//
+// log: the time per event of quantity_log::logger::write, with and
+// without reading the clock, and of formatting the event with an
+// ofstream (which is what operator<< does) in the logging thread
+//
+// ==========================================================================
+
+void bench_log(){
+   const std::size_t n = 10'000'000;
+   const char * path = "/tmp/test-benchmark.log";
+   static const quantity_log::site< double, type_multiset::one< tag_v > > 
+      site( "voltage {}" );
+   quantity_log::logger log;
+   log.open( path );
+   const auto stamped = best_of_3( [ & ](){
+      for( std::size_t i = 0; i < n; ++i ){
+         log.write( site, volt::from_raw( i * 0.125 ) );
+      }
+   } );
+   const auto given = best_of_3( [ & ](){
+      for( std::size_t i = 0; i < n; ++i ){
+         log.write( site, volt::from_raw( i * 0.125 ), i );
+      }
+   } );
+   log.close();
+   const auto streamed = best_of_3( [ & ](){
+      std::ofstream out( path );
+      for( std::size_t i = 0; i < n; ++i ){
+         out << "voltage " << i * 0.125;
+         type_multiset::print< type_multiset::one< tag_v > >( out );
+         out << "\n";
+      }
+   } );
+   std::remove( path );
+   std::printf( "log, 10^7 events: write %6.2f ns, "
+      "with a given timestamp %6.2f ns, ofstream %6.2f ns\n",
+      stamped / n * 1e9, given / n * 1e9, streamed / n * 1e9 );
+}
+
+
+
+// ==========================================================================
+//
+// SPSC ring: throughput of single values and of batches, and the
+// round trip latency of a value sent to a thread and back
+//
+// ==========================================================================
+
+static quantity_ring< double, type_multiset::one< tag_v >, 1024 > stream;
+static quantity_ring< double, type_multiset::one< tag_v >, 64 > request, reply;
+static quantity_timing::stage round_trip( "ring round trip" );
+
+void ring_throughput( std::size_t batch ){
+   const std::size_t total = 10'000'000;
+   const auto start = quantity_timing::now();
+   std::thread consumer( [ batch ](){
+      quantity_array< double, type_multiset::one< tag_v > > buffer( batch );
+      auto q = volt::from_raw( 0 );
+      for( std::size_t n = 0; n < total; ){
+         const auto k = batch == 1
+            ? ( stream.pop( q ) ? 1 : 0 )
+            : stream.pop( buffer.span() );
+         if( k == 0 ){
+            std::this_thread::yield();
+         }
+         n += k;
+      }
+   } );
+   quantity_array< double, type_multiset::one< tag_v > > values( batch );
+   for( std::size_t i = 0; i < batch; ++i ){
+      values[ i ] = volt::from_raw( i );
+   }
+   for( std::size_t n = 0; n < total; ){
+      const auto rest = total - n < batch ? total - n : batch;
+      const auto k = batch == 1
+         ? ( stream.push( values[ 0 ] ) ? 1 : 0 )
+         : stream.push( values.span().subspan( 0, rest ) );
+      if( k == 0 ){
+         std::this_thread::yield();
+      }
+      n += k;
+   }
+   consumer.join();
+   const auto elapsed = quantity_timing::now() - start;
+   std::printf( "ring, batches of %4zu: %8.2f M values/s\n",
+      batch, total / seconds( elapsed ) * 1e-6 );
+}
+
+void ring_latency(){
+   const int trips = 100'000;
+   std::thread echo( [](){
+      auto q = volt::from_raw( 0 );
+      for( int i = 0; i < trips; ++i ){
+         while( ! request.pop( q ) ){
+            std::this_thread::yield();
+         }
+         while( ! reply.push( q ) ){
+            std::this_thread::yield();
+         }
+      }
+   } );
+   auto q = volt::from_raw( 0 );
+   for( int i = 0; i < trips; ++i ){
+      quantity_timing::scope timer( round_trip );
+      request.push( volt::from_raw( i ) );
+      while( ! reply.pop( q ) ){
+         std::this_thread::yield();
+      }
+   }
+   echo.join();
+}
+
+void bench_ring(){
+   for( std::size_t batch : { 1, 16, 256 } ){
+      ring_throughput( batch );
+   }
+   ring_latency();
+}
+
+
+
+// ==========================================================================
+//
+// seqlock: reads and publishes per second, and the fraction of reads
+// that overlapped a publish, for one writer and 0 .. 4 readers
+//
+// ==========================================================================
+
+struct position {};
+struct speed {};
+struct tick {};
+
+using number = quantity_implementation< long long, type_multiset::empty >;
+using state = quantity_seqlock<
+   quantity_field< position, volt >,
+   quantity_field< speed, volt >,
+   quantity_field< tick, number > >;
+
+static state published;
+
+void seqlock_contention( int readers ){
+   const auto window = quantity_timing::duration::from_raw( 200'000'000 );
+   std::atomic< bool > done{ false };
+   std::atomic< unsigned long long > reads{ 0 }, retries{ 0 };
+   std::vector< std::thread > threads;
+   for( int i = 0; i < readers; ++i ){
+      threads.emplace_back( [ & ](){
+         unsigned long long n = 0, overlapped = 0;
+         state::record_type r;
+         while( ! done.load( std::memory_order_relaxed ) ){
+            if( published.try_read( r ) ){
+               ++n;
+            } else {
+               ++overlapped;
+            }
+         }
+         reads += n;
+         retries += overlapped;
+      } );
+   }
+   state::record_type w;
+   unsigned long long publishes = 0;
+   const auto start = quantity_timing::now();
+   auto elapsed = start - start;
+   while( elapsed < window ){
+      w.get< tick >() = number::from_raw( publishes );
+      published.publish( w );
+      ++publishes;
+      if( publishes % 1024 == 0 ){
+         elapsed = quantity_timing::now() - start;
+         std::this_thread::yield();
+      }
+   }
+   done = true;
+   for( auto & t : threads ){
+      t.join();
+   }
+   const auto attempts = reads + retries;
+   std::printf( "seqlock, %d readers: %8.2f M reads/s, %6.2f %% retried, "
+      "%8.2f M publishes/s\n",
+      readers, reads / seconds( elapsed ) * 1e-6,
+      attempts == 0 ? 0.0 : 100.0 * retries / attempts,
+      publishes / seconds( elapsed ) * 1e-6 );
+}
+
+void bench_seqlock(){
+   for( int readers : { 0, 1, 2, 4 } ){
+      seqlock_contention( readers );
+   }
+}
+
+
+
+// ==========================================================================
+//
+// main
+//
+// ==========================================================================
+
+int main(){
+   std::printf( "%u hardware threads\n", std::thread::hardware_concurrency() );
+   bench_algorithms();
+   bench_table();
+   bench_packed_array();
+   bench_codec();
+   bench_file();
+   bench_charconv();
+   bench_from_chars();
+   bench_format();
+   bench_log();
+   bench_csv();
+   bench_atomic();
+   bench_sharded_counter();
+   bench_ring();
+   bench_seqlock();
+   std::printf( "\n" );
+   quantity_timing::report< std::chrono::nanoseconds >( stdout );
+}
@@ -0,0 +1,62 @@
+// ==========================================================================
+//
+// test-codegen.cpp
+//
+// codegen test: quantity operators compile to the same code as
+// the same operations on the base values
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// This file is compiled to assembler twice: once as it is, and once
+// with CODEGEN_RAW defined, in which case the kernels use plain
+// doubles instead of quantities.
+// The two assembler files must be identical, which shows that
+// (with QUANTITY_COUNT_OPERATIONS not defined) the quantity
+// operators add nothing to the code.
+
+#include "quantity.hpp"
+
+struct tag_j { static constexpr const char * name = "J"; };
+struct tag_s { static constexpr const char * name = "s"; };
+
+#ifdef CODEGEN_RAW
+
+using energy   = double;
+using duration = double;
+
+#define FROM_RAW( type, x ) ( x )
+#define RAW( x ) ( x )
+
+#else
+
+using energy   = quantity_implementation< double, type_multiset::one< tag_j > >;
+using duration = quantity_implementation< double, type_multiset::one< tag_s > >;
+
+#define FROM_RAW( type, x ) type::from_raw( x )
+#define RAW( x ) ( x ).raw()
+
+#endif
+
+extern "C" double kernel_scale( double e, double factor ){
+   const energy scaled = FROM_RAW( energy, e ) / factor + FROM_RAW( energy, e );
+   return RAW( 3.0 * scaled );
+}
+
+extern "C" double kernel_sum( const double * e, int n ){
+   energy sum = FROM_RAW( energy, 0.0 );
+   for( int i = 0; i < n; ++i ){
+      sum += FROM_RAW( energy, e[ i ] ) * 2.0 - FROM_RAW( energy, 1.0 );
+   }
+   return RAW( - sum );
+}
+
+extern "C" int kernel_compare( double a, double b ){
+   return FROM_RAW( duration, a ) < FROM_RAW( duration, b );
+}
@@ -0,0 +1,131 @@
+// ==========================================================================
+//
+// test-counting.cpp
+//
+// runtime test of the operation counting
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// counting must be enabled before quantity.hpp is included,
+// hence this is not part of test-runtime.cpp
+#define QUANTITY_COUNT_OPERATIONS
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "quantity.hpp"
+
+struct tag_j { static constexpr const char * name = "J"; };
+struct tag_s { static constexpr const char * name = "s"; };
+
+using joule  = type_multiset::one< tag_j >;
+using second = type_multiset::one< tag_s >;
+using energy   = quantity_implementation< double, joule >;
+using duration = quantity_implementation< double, second >;
+using operation = quantity_counting::operation;
+
+int tests_failed = 0;
+
+void check( bool ok, const char * what ){
+   if( ! ok ){
+      ++tests_failed;
+      std::cout << "check failed: " << what << "\n";
+   }
+}
+
+// the total count of op on operands with the tag names left and right
+std::uint64_t total( operation op, const char * left, const char * right ){
+   std::uint64_t n = 0;
+   for( const auto & e : quantity_counting::totals() ){
+      if( e.op == op
+         && std::strcmp( e.left, left ) == 0
+         && std::strcmp( e.right, right ) == 0
+      ){
+         n += e.count;
+      }
+   }
+   return n;
+}
+
+int main(){
+
+   // a constant evaluation is not counted
+   constexpr auto twice = energy::one * 2;
+   check( total( operation::multiply, "J", "" ) == 0, "constexpr multiply" );
+
+   energy e = twice;
+   const duration t = duration::one * 4.0;
+   for( int i = 0; i < 10; ++i ){
+      e += e / 2.0;
+   }
+   check( total( operation::add_assign, "J", "J" ) == 10, "+=" );
+   check( total( operation::divide, "J", "" ) == 10, "J / value" );
+   check( total( operation::multiply, "s", "" ) == 1, "s * value" );
+
+   const auto inverse = 1.0 / t;
+   check( total( operation::divide, "", "s" ) == 1, "value / s" );
+   check( ( - t ) < t && inverse.raw() == 0.25, "values" );
+   check( total( operation::minus, "s", "" ) == 1, "- s" );
+   check( total( operation::compare, "s", "s" ) == 1, "s < s" );
+
+   // other threads add their counts when they end
+   std::thread other( [](){
+      energy x = energy::one;
+      for( int i = 0; i < 5; ++i ){
+         x = x + x;
+      }
+   } );
+   other.join();
+   check( total( operation::add, "J", "J" ) == 5, "J + J in a thread" );
+
+   std::FILE * file = std::tmpfile();
+   quantity_counting::report( file );
+   std::rewind( file );
+   char line[ 100 ] = "";
+   check( std::fgets( line, sizeof( line ), file ) != nullptr, "report" );
+   std::fclose( file );
+   check( std::string( line ) == "          10  J += J\n"
+      || std::string( line ) == "          10  J / 1\n", "report first line" );
+
+   // a child process writes its report when it exits, after
+   // the counts of its main thread have been merged for the last time
+   const char * path = "test-counting-report.tmp";
+   const pid_t child = fork();
+   if( child == 0 ){
+      quantity_counting::report_at_exit( path );
+      energy x = energy::one;
+      for( int i = 0; i < 3; ++i ){
+         x = x + x;
+      }
+      std::exit( x.raw() == 8.0 ? 0 : 1 );
+   }
+   int status = -1;
+   waitpid( child, & status, 0 );
+   check( WIFEXITED( status ) && WEXITSTATUS( status ) == 0, "child exit" );
+   bool reported = false;
+   file = std::fopen( path, "r" );
+   check( file != nullptr, "exit report file" );
+   while( file != nullptr && std::fgets( line, sizeof( line ), file ) != nullptr ){
+      reported = reported || std::string( line ) == "           8  J + J\n";
+   }
+   if( file != nullptr ){
+      std::fclose( file );
+   }
+   std::remove( path );
+   check( reported, "exit report: the 5 + 3 J + J of both threads" );
+
+   if( tests_failed == 0 ){
+      std::cout << "Counting test success\n";
+   }
+   return tests_failed == 0 ? 0 : 1;
+}
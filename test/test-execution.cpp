@@ -0,0 +1,96 @@
+// ==========================================================================
+//
+// test-execution.cpp
+//
+// runtime test of the std::execution policies in the algorithms
+//
+// https://www.github.com/wovo/quantity
+//
+// Copyright Wouter van Ooijen - 2019
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// https://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// <execution> must be included before quantity_parallel.hpp,
+// and with libstdc++ it requires linking with TBB,
+// hence this is not part of test-runtime.cpp
+#if __has_include( <execution> )
+   #include <execution>
+#endif
+
+#include <iostream>
+#include "quantity.hpp"
+#include "quantity_algorithms.hpp"
+
+int tests_failed = 0;
+
+void check( bool ok, const char * what ){
+   if( ! ok ){
+      ++tests_failed;
+      std::cout << "check failed: " << what << "\n";
+   }
+}
+
+#ifdef __cpp_lib_execution
+
+struct tag_m { static constexpr const char * name = "m"; };
+
+using metre = quantity_implementation< long long, type_multiset::one< tag_m > >;
+
+// the algorithms give the same results with policy P
+template< typename P >
+void check_algorithms( const P & policy, const char * what ){
+   const std::size_t n = 3 * quantity_parallel::grain + 7;
+   quantity_array< long long, type_multiset::one< tag_m > > x( n );
+   long long sum = 0;
+   for( std::size_t i = 0; i < n; ++i ){
+      x[ i ] = metre::from_raw( ( i * 13 ) % 101 );
+      sum += ( i * 13 ) % 101;
+   }
+   check( quantity_algorithms::reduce( policy, x.span() ).raw() == sum, what );
+   const auto mm = quantity_algorithms::minmax( policy, x.span() );
+   check( mm.first.raw() == 0 && mm.second.raw() == 100, what );
+}
+
+int main(){
+   using quantity_parallel::is_parallel;
+   using quantity_parallel::chunks;
+   const std::size_t n = 8 * quantity_parallel::grain;
+   const auto threads = quantity_parallel::max_threads();
+
+   check( quantity_parallel::execution_policy< decltype( std::execution::par ) >,
+      "par is accepted" );
+   check( ! is_parallel< std::execution::sequenced_policy >::value, "seq" );
+   check( is_parallel< std::execution::parallel_policy >::value, "par" );
+   check( is_parallel< std::execution::parallel_unsequenced_policy >::value,
+      "par_unseq" );
+   check( chunks( std::execution::seq, n ) == 1, "seq chunks" );
+   check( chunks( std::execution::par, n ) == ( threads < 8 ? threads : 8 ),
+      "par chunks" );
+
+#if __cpp_lib_execution >= 201902L
+   // unseq allows vectorization, not other threads
+   check( ! is_parallel< std::execution::unsequenced_policy >::value, "unseq" );
+   check( chunks( std::execution::unseq, n ) == 1, "unseq chunks" );
+   check_algorithms( std::execution::unseq, "algorithms with unseq" );
+#endif
+
+   check_algorithms( std::execution::seq, "algorithms with seq" );
+   check_algorithms( std::execution::par, "algorithms with par" );
+   check_algorithms( std::execution::par_unseq, "algorithms with par_unseq" );
+
+   if( tests_failed == 0 ){
+      std::cout << "Execution policy test success\n";
+   }
+   return tests_failed == 0 ? 0 : 1;
+}
+
+#else
+
+int main(){
+   std::cout << "Execution policy test skipped: no std::execution\n";
+}
+
+#endif
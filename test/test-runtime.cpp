@@ -16,7 +16,32 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <limits>
 #include "quantity.hpp"
+#include "quantity_array.hpp"
+#include "quantity_algorithms.hpp"
+#include "quantity_expressions.hpp"
+#include "quantity_table.hpp"
+#include "quantity_record.hpp"
+#include "quantity_packed_array.hpp"
+#include "quantity_codec.hpp"
+#include "quantity_file.hpp"
+#include "quantity_serialize.hpp"
+#include "quantity_shared_ring.hpp"
+#include "quantity_charconv.hpp"
+#include "quantity_format.hpp"
+#include "quantity_csv.hpp"
+#include "quantity_export.hpp"
+#include "quantity_log.hpp"
+#include "quantity_atomic.hpp"
+#include "quantity_sharded_counter.hpp"
+#include "quantity_ring.hpp"
+#include "quantity_seqlock.hpp"
+#include "quantity_timing.hpp"
+#include "quantity_statistics.hpp"
+#include <thread>
+#include <csignal>
+#include <sys/wait.h>
 
 
 // ==========================================================================
@@ -95,6 +120,7 @@ struct tag_a { static const char name = 'a'; };
 struct tag_b { static const char name = 'b'; };
 struct tag_c { static const char name = 'c'; };
 struct tag_d { static const char name = 'd'; };
+struct tag_kg { static constexpr const char * name = "kg"; };
 
 using a = type_multiset::one< tag_a >;
 using b = type_multiset::one< tag_b >;
@@ -311,6 +337,49 @@ void test_multiset_add_prune(){
 	
 }
 
+template< typename T >
+unsigned long long fingerprint(){
+   return type_multiset::fingerprint< T >::value;
+}
+
+void test_multiset_fingerprint(){
+   using a_b = type_multiset::add< ab, type_multiset::multiply< b, -1 > >;
+   
+   CHECK_EQUAL( fingerprint< ab >(), fingerprint< ba >() );
+   CHECK_EQUAL( fingerprint< a2b2 >(), fingerprint< b2a2 >() );
+   CHECK_EQUAL( fingerprint< a >(), fingerprint< a_b >() );
+   CHECK_NOT_EQUAL( fingerprint< a >(), fingerprint< b >() );
+   CHECK_NOT_EQUAL( fingerprint< a >(), fingerprint< a2 >() );
+   CHECK_NOT_EQUAL( fingerprint< a2b >(), fingerprint< ab2 >() );
+   CHECK_NOT_EQUAL( fingerprint< type_multiset::empty >(), fingerprint< a >() );
+}
+
+void test_multiset_name(){
+   using kg   = type_multiset::one< tag_kg >;
+   using kgb  = type_multiset::add< kg, b >;
+   using bkg  = type_multiset::add< b, kg >;
+   using neg  = type_multiset::multiply< ab2, -10 >;
+   
+   CHECK_EQUAL( std::string( type_multiset::name_v< type_multiset::empty > ), "" );
+   CHECK_EQUAL( std::string( type_multiset::name_v< a > ), "a" );
+   CHECK_EQUAL( std::string( type_multiset::name_v< ba > ), "ab" );
+   CHECK_EQUAL( std::string( type_multiset::name_v< b2a > ), "ab2" );
+   CHECK_EQUAL( std::string( type_multiset::name_v< kgb > ), "bkg" );
+   CHECK_EQUAL( std::string( type_multiset::name_v< neg > ), "a-10b-20" );
+   CHECK_EQUAL( sizeof( type_multiset::name_v< neg > ), 9 );
+   
+   // equal multisets share one string
+   const char * ab_name  = type_multiset::name_v< ab >;
+   const char * ba_name  = type_multiset::name_v< ba >;
+   const char * kgb_name = type_multiset::name_v< kgb >;
+   const char * bkg_name = type_multiset::name_v< bkg >;
+   CHECK_TRUE( ab_name == ba_name );
+   CHECK_TRUE( kgb_name == bkg_name );
+   
+   // and it is available at compile time
+   static_assert( type_multiset::name_v< b2a2 >[ 3 ] == '2', "" );
+}
+
 void test_multiset_equal(){
 
    { auto x = type_multiset::equal< 
@@ -459,6 +528,1574 @@ void test_multiply(){
 }
 
 
+// ==========================================================================
+//
+// array algorithm tests
+//
+// ==========================================================================
+
+using qm    = quantity_implementation< long long, a >;
+using qs    = quantity_implementation< long long, b >;
+
+void test_scan(){
+
+   // small enough for one thread, and large enough to be split
+   for( std::size_t n : { 5ul, 4 * quantity_parallel::grain + 3 } ){
+      quantity_array< long long, a > in( n ), inclusive( n ), exclusive( n );
+      for( std::size_t i = 0; i < n; ++i ){
+         in[ i ] = qm::from_raw( i % 7 );
+      }
+      quantity_algorithms::inclusive_scan( in.span(), inclusive.span() );
+      quantity_algorithms::exclusive_scan( in.span(), exclusive.span() );
+
+      long long sum = 0;
+      bool ok = true;
+      for( std::size_t i = 0; i < n; ++i ){
+         ok = ok && ( exclusive[ i ].raw() == sum );
+         sum += i % 7;
+         ok = ok && ( inclusive[ i ].raw() == sum );
+      }
+      CHECK_TRUE( ok );
+
+      quantity_array< long long, a > difference( n );
+      quantity_algorithms::adjacent_difference( 
+         inclusive.span(), difference.span() );
+      ok = true;
+      for( std::size_t i = 0; i < n; ++i ){
+         ok = ok && ( difference[ i ] == in[ i ] );
+      }
+      CHECK_TRUE( ok );
+      
+      // in place
+      quantity_algorithms::exclusive_scan( in.span(), in.span() );
+      quantity_algorithms::inclusive_scan( 
+         difference.span(), difference.span() );
+      ok = true;
+      for( std::size_t i = 0; i < n; ++i ){
+         ok = ok && ( in[ i ] == exclusive[ i ] );
+         ok = ok && ( difference[ i ] == inclusive[ i ] );
+      }
+      CHECK_TRUE( ok );
+   }
+}
+
+void test_integrate(){
+   const std::size_t n = 3 * quantity_parallel::grain + 1;
+   quantity_array< long long, a > speed( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      speed[ i ] = qm::from_raw( 2 * i );
+   }
+   
+   // integral of 2 t dt is t * t 
+   quantity_array< long long, type_multiset::add< a, b > > distance( n );
+   quantity_algorithms::integrate( 
+      speed.span(), qs::from_raw( 1 ), distance.span() );
+   bool ok = true;
+   for( std::size_t i = 0; i < n; ++i ){
+      ok = ok && ( distance[ i ].raw() == (long long)( i * i ) );
+   }
+   CHECK_TRUE( ok );
+   
+   // and back
+   quantity_array< long long, a > speed2( n - 1 );
+   quantity_algorithms::differentiate( 
+      distance.span(), qs::from_raw( 1 ), speed2.span() );
+   ok = true;
+   for( std::size_t i = 0; i < n - 1; ++i ){
+      ok = ok && ( speed2[ i ].raw() == (long long)( 2 * i + 1 ) );
+   }
+   CHECK_TRUE( ok );
+   
+   // differentiate with respect to a quantity: a / b
+   quantity_array< long long, type_multiset::add< 
+      a, type_multiset::multiply< b, -1 > > > rate( 4 );
+   quantity_algorithms::differentiate( 
+      speed.span().subspan( 0, 5 ), qs::from_raw( 2 ), rate.span() );
+   CHECK_EQUAL( rate[ 3 ].raw(), 1 );
+   
+   // in place, over a dimensionless interval
+   using step = quantity_implementation< long long, type_multiset::empty >;
+   quantity_algorithms::integrate( speed.span(), step::from_raw( 1 ), speed.span() );
+   ok = true;
+   for( std::size_t i = 0; i < n; ++i ){
+      ok = ok && ( speed[ i ].raw() == (long long)( i * i ) );
+   }
+   CHECK_TRUE( ok );
+}
+
+void test_parallel_algorithms(){
+   const std::size_t n = 5 * quantity_parallel::grain + 11;
+   quantity_array< long long, a > x( n );
+   quantity_array< long long, b > y( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      x[ i ] = qm::from_raw( ( i * 37 ) % 1001 );
+      y[ i ] = qs::from_raw( 2 );
+   }
+   x[ 12345 ] = qm::from_raw( -5 );
+   x[ 3 * quantity_parallel::grain ] = qm::from_raw( 5000 );
+
+   for( int parallel = 0; parallel < 2; ++parallel ){
+      auto run = [ & ]( auto policy ){
+      
+         // transform: the result has the tag type of f( x )
+         using qab = quantity_implementation< 
+            long long, type_multiset::add< b, a > >;
+         quantity_array< long long, type_multiset::add< a, b > > xy( n );
+         quantity_algorithms::transform( policy, x.span(), y.span(), xy.span(),
+            []( const auto & l, const auto & r ){ 
+               return qab::from_raw( l.raw() * r.raw() ); } );
+         CHECK_EQUAL( xy[ 7 ].raw(), 2 * ( ( 7 * 37 ) % 1001 ) );   
+         
+         quantity_array< long long, a > x2( n );
+         quantity_algorithms::transform( policy, x.span(), x2.span(),
+            []( const auto & q ){ return q + q; } );
+         CHECK_TRUE( x2[ n - 1 ] == x[ n - 1 ] * 2 );
+         
+         long long sum = 0;
+         for( std::size_t i = 0; i < n; ++i ){
+            sum += x[ i ].raw();
+         }
+         CHECK_EQUAL( quantity_algorithms::reduce( policy, x.span() ).raw(), sum );
+         CHECK_EQUAL( quantity_algorithms::reduce( 
+            policy, x.span(), qm::from_raw( 1 ),
+            []( const auto & l, const auto & r ){ return l + r; } ).raw(), 
+            sum + 1 );
+         CHECK_EQUAL( quantity_algorithms::transform_reduce( 
+            policy, x.span(), y.span() ).raw(), 2 * sum );
+         CHECK_EQUAL( quantity_algorithms::transform_reduce( 
+            policy, x.span(), 0LL,
+            []( long long l, long long r ){ return l + r; },
+            []( const auto & q ){ return q.raw() * 3; } ), 3 * sum );
+            
+         CHECK_EQUAL( 
+            quantity_algorithms::min_element( policy, x.span() ) - x.begin(), 
+            12345 );
+         auto mm = quantity_algorithms::minmax( policy, x.span() );
+         CHECK_EQUAL( mm.first.raw(), -5 );
+         CHECK_EQUAL( mm.second.raw(), 5000 );
+         auto none = quantity_algorithms::minmax( policy, x.span().subspan( 0, 0 ) );
+         CHECK_EQUAL( none.first.raw(), 0 );
+         CHECK_EQUAL( none.second.raw(), 0 );
+         CHECK_EQUAL( quantity_algorithms::count_if( policy, x.span(),
+            []( const auto & q ){ return q > qm::from_raw( 1000 ); } ), 1 );
+      };
+      if( parallel ){
+         run( quantity_parallel::par );
+      } else {
+         run( quantity_parallel::seq );
+      }
+   }
+
+   // a thread limit limits the number of chunks
+   const auto threads = quantity_parallel::pool().threads();
+   CHECK_EQUAL( quantity_parallel::chunks( quantity_parallel::par, n ),
+      threads < 5 ? threads : 5 );
+   quantity_parallel::limit_threads( 1 );
+   CHECK_EQUAL( quantity_parallel::chunks( quantity_parallel::par, n ), 1 );
+   auto limited = quantity_algorithms::minmax( quantity_parallel::par, x.span() );
+   CHECK_EQUAL( limited.second.raw(), 5000 );
+   quantity_parallel::limit_threads( 0 );
+   CHECK_EQUAL( quantity_parallel::max_threads(), threads );
+}
+
+void test_expressions(){
+   using namespace quantity_expressions;
+   const std::size_t n = 3 * quantity_parallel::grain + 5;
+   quantity_array< long long, a > x( n ), z( n );
+   quantity_array< long long, b > y( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      x[ i ] = qm::from_raw( i );
+      y[ i ] = qs::from_raw( 3 );
+   }
+   
+   // a * b + a * b, with the tag type ( ab ) in the expression type
+   quantity_array< long long, type_multiset::add< b, a > > xy( n );
+   lazy( xy ) = lazy( x ) * lazy( y ) + 2 * lazy( x ) * lazy( y );
+   CHECK_EQUAL( xy[ n - 1 ].raw(), (long long)( 9 * ( n - 1 ) ) );
+   
+   // and back to a
+   evaluate( z.span(), ( lazy( xy ) - lazy( x ) * lazy( qs::one ) ) / lazy( y ) );
+   bool ok = true;
+   for( std::size_t i = 0; i < n; ++i ){
+      ok = ok && ( z[ i ].raw() == (long long)( ( 8 * i ) / 3 ) );
+   }
+   CHECK_TRUE( ok );
+   
+   // assigning a plain copy
+   quantity_array< long long, a > w( n );
+   lazy( w ) = lazy( x );
+   CHECK_TRUE( w[ 17 ] == x[ 17 ] );
+   
+   // a span that is shorter than the result
+   const auto shorter = x.span().subspan( 0, n - 1 );
+   z[ n - 1 ] = qm::from_raw( -1 );
+   auto fits = evaluate( z.span(), lazy( shorter ) + lazy( x ) );
+   CHECK_TRUE( ! fits );
+   CHECK_EQUAL( z[ n - 1 ].raw(), -1 );
+   fits = evaluate( z.span().subspan( 0, n - 1 ), lazy( shorter ) * 2 );
+   CHECK_TRUE( fits );
+   CHECK_EQUAL( z[ n - 2 ].raw(), (long long)( 2 * ( n - 2 ) ) );
+#ifndef NDEBUG
+   // assigning it is an assertion failure
+   const pid_t child = fork();
+   if( child == 0 ){
+      close( 2 );
+      lazy( z ) = lazy( shorter ) - lazy( x );
+      _exit( 0 );
+   }
+   int status = 0;
+   waitpid( child, & status, 0 );
+   CHECK_TRUE( WIFSIGNALED( status ) && WTERMSIG( status ) == SIGABRT );
+#endif
+}
+
+void test_table(){
+   using qi = quantity_implementation< int, c >;
+   quantity_table< qm, quantity< int, tag_c >, qs > table;
+   table.reserve( 10 );
+   for( int i = 0; i < 10; ++i ){
+      table.push_back( qm::from_raw( i ), qi::from_raw( 2 * i ), qs::from_raw( 3 ) );
+   }
+   CHECK_EQUAL( table.size(), 10 );
+   CHECK_EQUAL( table[ 4 ].get< 1 >().raw(), 8 );
+   
+   // the row proxy gives the quantity type of the field
+   table[ 4 ].get< 0 >() += qm::one;
+   CHECK_EQUAL( table[ 4 ].get< 0 >().raw(), 5 );
+   
+   // each column is a span
+   const auto & t = table;
+   CHECK_EQUAL( t.column< 1 >().size(), 10 );
+   CHECK_EQUAL( quantity_algorithms::reduce( 
+      quantity_parallel::seq, t.column< 0 >() ).raw(), 46 );
+      
+   table.resize( 20 );
+   CHECK_EQUAL( table.column< 2 >().size(), 20 );
+   CHECK_EQUAL( table[ 9 ].get< 2 >().raw(), 3 );
+}
+
+void test_record(){
+   using q8  = quantity_implementation< signed char, a >;
+   using q16 = quantity_implementation< short, b >;
+   using q64 = quantity_implementation< double, c >;
+   struct status {};
+   struct adc {};
+   struct timestamp {};
+   struct flags {};
+   
+   using record = quantity_record< 
+      quantity_field< status, q8 >,
+      quantity_field< adc, q16 >,
+      quantity_field< timestamp, q64 >,
+      quantity_field< flags, q8 > >;
+   struct naive { q8 status; q16 adc; q64 timestamp; q8 flags; };   
+      
+   // 8 + 2 + 1 + 1 rounded up to 8, a plain struct needs 24
+   CHECK_EQUAL( sizeof( record ), 16 );
+   CHECK_EQUAL( record::minimum_size, 16 );
+   CHECK_TRUE( sizeof( record ) < sizeof( naive ) );
+   CHECK_EQUAL( alignof( record ), alignof( double ) );
+   CHECK_EQUAL( record::offsets[ 2 ], 0 );
+   CHECK_TRUE( std::is_trivially_copyable< record >::value );
+      
+   record r;
+   CHECK_EQUAL( r.get< adc >().raw(), 0 );
+   r.get< status >() = q8::from_raw( -3 );
+   r.get< adc >() = q16::from_raw( 4095 );
+   r.get< timestamp >() = q64::from_raw( 1.5 );
+   r.get< flags >() = q8::from_raw( 7 );
+   const record copy = r;
+   CHECK_EQUAL( copy.get< status >().raw(), -3 );
+   CHECK_EQUAL( copy.get< adc >().raw(), 4095 );
+   CHECK_EQUAL( copy.get< timestamp >().raw(), 1.5 );
+   CHECK_EQUAL( copy.get< flags >().raw(), 7 );
+}
+
+void test_packed_array(){
+   using q16 = quantity_implementation< unsigned short, a >;
+   using qs16 = quantity_implementation< short, a >;
+   const std::size_t n = 1000;
+   
+   quantity_array< unsigned short, a > adc( n ), back( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      adc[ i ] = q16::from_raw( ( i * 2654435761u ) % 4096 );
+   }
+   quantity_packed_array< unsigned short, a, 12 > packed;
+   packed.pack( adc );
+   CHECK_EQUAL( packed.size(), n );
+   CHECK_TRUE( packed.bytes() < n * sizeof( unsigned short ) );
+   packed.unpack( back );
+   bool ok = true;
+   for( std::size_t i = 0; i < n; ++i ){
+      ok = ok && ( back[ i ] == adc[ i ] ) && ( packed[ i ] == adc[ i ] );
+   }
+   CHECK_TRUE( ok );
+   
+   // single element update doesn't disturb the neighbours
+   packed.set( 5, q16::from_raw( 4095 ) );
+   packed.set( 6, q16::from_raw( 0 ) );
+   CHECK_EQUAL( packed[ 5 ].raw(), 4095 );
+   CHECK_EQUAL( packed[ 6 ].raw(), 0 );
+   CHECK_TRUE( packed[ 4 ] == adc[ 4 ] );
+   CHECK_TRUE( packed[ 7 ] == adc[ 7 ] );
+   
+   // iteration
+   std::size_t count = 0;
+   for( auto q : packed ){
+      count += ( q.raw() < 4096 );
+   }
+   CHECK_EQUAL( count, n );
+   
+   // signed values are sign-extended
+   quantity_packed_array< short, a, 10 > s( 100 );
+   s.set( 63, qs16::from_raw( -512 ) );
+   s.set( 64, qs16::from_raw( 511 ) );
+   s.set( 65, qs16::from_raw( -1 ) );
+   CHECK_EQUAL( s[ 63 ].raw(), -512 );
+   CHECK_EQUAL( s[ 64 ].raw(), 511 );
+   CHECK_EQUAL( s[ 65 ].raw(), -1 );
+   CHECK_EQUAL( s[ 66 ].raw(), 0 );
+   
+   // shrinking clears the removed elements
+   s.resize( 64 );
+   s.resize( 100 );
+   CHECK_EQUAL( s[ 64 ].raw(), 0 );
+   CHECK_EQUAL( s[ 65 ].raw(), 0 );
+}
+
+void test_codec(){
+   using q32 = quantity_implementation< int, a >;
+   const std::size_t n = 1000;
+   quantity_array< int, a > series( n ), back( n + 10 );
+   for( std::size_t i = 0; i < n; ++i ){
+      // a slowly changing value, with a jump between blocks
+      series[ i ] = q32::from_raw( 
+         20000 + (int)( i % 13 ) - 6 - ( i >= 500 ? 1000000 : 0 ) );
+   }
+   series[ 300 ] = q32::from_raw( -2147483647 - 1 );
+
+   quantity_codec::encoder< int, a > encoder;
+   encoder.write( series );
+   encoder.flush();
+   CHECK_TRUE( encoder.data().size() < n * sizeof( int ) / 2 );
+   
+   quantity_codec::decoder< int, a > decoder( 
+      encoder.data().data(), encoder.data().size() );
+   auto first = decoder.read( back.span().subspan( 0, 200 ) );
+   auto rest = decoder.read( back.span().subspan( 200, n - 200 + 10 ) );
+   CHECK_EQUAL( first, 200 );
+   CHECK_EQUAL( rest, n - 200 );
+   CHECK_TRUE( decoder.status() == quantity_codec::error::end );
+   bool ok = true;
+   for( std::size_t i = 0; i < n; ++i ){
+      ok = ok && ( back[ i ] == series[ i ] );
+   }
+   CHECK_TRUE( ok );
+   
+   // a counter needs only the block headers
+   quantity_codec::encoder< int, a > counter;
+   for( int i = 0; i < 1280; ++i ){
+      counter.write( q32::from_raw( 3 * i ) );
+   }
+   CHECK_EQUAL( counter.data().size(), 10 * quantity_codec::header_size );
+   
+   // another tag type is refused
+   quantity_array< int, b > other( n );
+   quantity_codec::decoder< int, b > wrong( 
+      encoder.data().data(), encoder.data().size() );
+   auto none = wrong.read( other );
+   CHECK_EQUAL( none, 0 );
+   CHECK_TRUE( wrong.status() == quantity_codec::error::wrong_dimension );
+   
+   // and so is an incomplete block
+   quantity_codec::decoder< int, a > truncated( 
+      encoder.data().data(), encoder.data().size() - 1 );
+   auto complete = truncated.read( back );
+   CHECK_EQUAL( complete, 896 );
+   CHECK_TRUE( truncated.status() == quantity_codec::error::truncated );
+}
+
+void test_file(){
+   using qd = quantity_implementation< double, a >;
+   const char * path = "test-runtime-quantity-file.tmp";
+   const std::size_t n = 10000;
+   quantity_array< double, a > values( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      values[ i ] = qd::from_raw( i * 0.5 );
+   }
+   
+   {  quantity_file::writer< double, a > writer;
+      auto opened = writer.open( path );
+      auto head = writer.write( values.span().subspan( 0, 10 ) );
+      auto tail = writer.write( values.span().subspan( 10, n - 10 ) );
+      CHECK_TRUE( opened == quantity_file::error::none );
+      CHECK_TRUE( head == quantity_file::error::none );
+      CHECK_TRUE( tail == quantity_file::error::none );
+   }
+   
+   quantity_file::reader< double, a > reader;
+   auto opened = reader.open( path );
+   CHECK_TRUE( opened == quantity_file::error::none );
+   CHECK_EQUAL( reader.size(), n );
+   CHECK_TRUE( reader.span()[ n - 1 ] == values[ n - 1 ] );
+   CHECK_EQUAL( quantity_algorithms::reduce( 
+      quantity_parallel::par, reader.span() ).raw(), 0.25 * n * ( n - 1 ) );
+   reader.close();
+   
+   // the header is checked against the requested type
+   quantity_file::reader< double, b > other_tags;
+   opened = other_tags.open( path );
+   CHECK_TRUE( opened == quantity_file::error::wrong_dimension );
+   CHECK_EQUAL( other_tags.size(), 0 );
+   quantity_file::reader< float, a > other_value;
+   opened = other_value.open( path );
+   CHECK_TRUE( opened == quantity_file::error::wrong_value_type );
+   quantity_file::reader< double, a > missing;
+   opened = missing.open( "no such file" );
+   CHECK_TRUE( opened == quantity_file::error::cannot_open );
+   
+   ::truncate( path, 64 + 8 * ( n - 1 ) );
+   opened = reader.open( path );
+   CHECK_TRUE( opened == quantity_file::error::truncated );
+   ::unlink( path );
+}
+
+void test_file_zones(){
+   using qi = quantity_implementation< int, a >;
+   const char * path = "test-runtime-quantity-zones.tmp";
+   const std::size_t n = 10050;
+   quantity_array< int, a > values( n );
+   for( std::size_t i = 0; i < n; ++i ){
+      // mostly increasing, so most zones are either all in or all out
+      values[ i ] = qi::from_raw( (int) i + (int)( i % 7 ) * 3 );
+   }
+   {  quantity_file::writer< int, a > writer( 100 );
+      auto opened = writer.open( path );
+      auto written = writer.write( values );
+      CHECK_TRUE( opened == quantity_file::error::none );
+      CHECK_TRUE( written == quantity_file::error::none );
+   }
+   
+   quantity_file::reader< int, a > reader;
+   auto opened = reader.open( path );
+   CHECK_TRUE( opened == quantity_file::error::none );
+   
+   auto brute = [ & ]( const quantity_file::condition< int, a > & c ){
+      std::size_t k = 0;
+      long long sum = 0;
+      for( std::size_t i = 0; i < n; ++i ){
+         if( c.matches( values[ i ].raw() ) ){
+            ++k;
+            sum += values[ i ].raw();
+         }
+      }
+      return std::make_pair( k, sum );
+   };
+   
+   for( auto c : { 
+      quantity_file::greater( qi::from_raw( 5000 ) ),
+      quantity_file::greater_equal( qi::from_raw( 5000 ) ),
+      quantity_file::less( qi::from_raw( 17 ) ),
+      quantity_file::less_equal( qi::from_raw( -1 ) ),
+      quantity_file::between( qi::from_raw( 1234 ), qi::from_raw( 4321 ) )
+   } ){
+      auto expected = brute( c );
+      CHECK_EQUAL( reader.count( c ), expected.first );
+      CHECK_EQUAL( reader.sum( c ).raw(), expected.second );
+      std::size_t k = 0;
+      bool ok = true;
+      reader.for_each( c, [ & ]( std::size_t i, const qi & q ){
+         ++k;
+         ok = ok && ( q == values[ i ] );
+      } );
+      CHECK_EQUAL( k, expected.first );
+      CHECK_TRUE( ok );
+   }
+   ::unlink( path );
+}
+
+void test_file_zones_nan(){
+   using qd = quantity_implementation< double, a >;
+   using reader_type = quantity_file::reader< double, a >;
+   const char * path = "test-runtime-quantity-nan.tmp";
+   quantity_array< double, a > values( 10 );
+   for( int i = 0; i < 10; ++i ){
+      values[ i ] = qd::from_raw( i );
+   }
+   
+   // a NaN as the first value of a zone, and one later in a zone
+   values[ 0 ] = qd::from_raw( std::numeric_limits< double >::quiet_NaN() );
+   values[ 7 ] = values[ 0 ];
+   {  quantity_file::writer< double, a > writer( 5 );
+      auto opened = writer.open( path );
+      auto written = writer.write( values );
+      CHECK_TRUE( opened == quantity_file::error::none );
+      CHECK_TRUE( written == quantity_file::error::none );
+   }
+   reader_type reader;
+   auto opened = reader.open( path );
+   CHECK_TRUE( opened == quantity_file::error::none );
+   
+   const auto low = qd::from_raw( 2.5 );
+   const auto high = qd::from_raw( 6.5 );
+   CHECK_EQUAL( reader.count( quantity_file::greater( low ) ), 6 );
+   CHECK_EQUAL( reader.count( quantity_file::greater_equal( low ) ), 6 );
+   CHECK_EQUAL( reader.sum( quantity_file::greater( low ) ).raw(), 35.0 );
+   CHECK_EQUAL( reader.count( quantity_file::between( low, high ) ), 4 );
+   CHECK_EQUAL( reader.sum( quantity_file::between( low, high ) ).raw(), 18.0 );
+   CHECK_EQUAL( reader.count( quantity_file::less_equal( high ) ), 6 );
+   CHECK_EQUAL( reader.sum( quantity_file::less( qd::from_raw( 100 ) ) ).raw(),
+      38.0 );
+   CHECK_TRUE( ! quantity_file::greater_equal( low ).matches( 
+      values[ 0 ].raw() ) );
+   reader.close();
+   
+   // a zone size of 0 is rejected
+   quantity_file::writer< double, a > bad( 0 );
+   auto rejected = bad.open( path );
+   CHECK_TRUE( rejected == quantity_file::error::bad_zone_size );
+   ::unlink( path );
+}
+
+void test_serialize(){
+   using qd  = quantity_implementation< double, ab >;
+   using qd2 = quantity_implementation< double, ba >;
+   using qe  = quantity_implementation< double, a2b >;
+   unsigned char buffer[ 200 ];
+   
+   // a single quantity, read back as an equal (but differently built) type
+   auto end = quantity_serialize::write( buffer, qd::from_raw( 2.5 ) );
+   CHECK_EQUAL( end - buffer, 16 );
+   CHECK_EQUAL( quantity_serialize::size( qd::one ), 16 );
+   const unsigned char * p = buffer;
+   auto x = qd2::from_raw( 0 );
+   auto result = quantity_serialize::read( p, end, x );
+   CHECK_TRUE( result == quantity_serialize::error::none );
+   CHECK_EQUAL( x.raw(), 2.5 );
+   CHECK_TRUE( p == end );
+   
+   // another tag type is refused
+   p = buffer;
+   auto y = qe::from_raw( 0 );
+   result = quantity_serialize::read( p, end, y );
+   CHECK_TRUE( result == quantity_serialize::error::wrong_dimension );
+   CHECK_TRUE( p == buffer );
+   
+   // as is a too short buffer
+   result = quantity_serialize::read( p, end - 1, x );
+   CHECK_TRUE( result == quantity_serialize::error::too_short );
+   
+   // a span
+   quantity_array< double, ab > values( 10 ), back( 20 );
+   for( int i = 0; i < 10; ++i ){
+      values[ i ] = qd::from_raw( i * 1.5 );
+   }
+   end = quantity_serialize::write( buffer, values.span() );
+   CHECK_EQUAL( (std::size_t)( end - buffer ), 
+      quantity_serialize::size( values.span() ) );
+   p = buffer;
+   std::size_t n = 0;
+   result = quantity_serialize::read( p, end, back.span(), n );
+   CHECK_TRUE( result == quantity_serialize::error::none );
+   CHECK_EQUAL( n, 10 );
+   CHECK_TRUE( back[ 9 ] == values[ 9 ] );
+   
+   p = buffer;
+   result = quantity_serialize::read( p, end, back.span().subspan( 0, 9 ), n );
+   CHECK_TRUE( result == quantity_serialize::error::too_short );
+}
+
+
+
+void test_shared_ring(){
+   using ring = quantity_shared_ring< long long, a >;
+   const char * name = "/test-runtime-quantity-ring";
+   ring::remove( name );
+   
+   ring producer;
+   auto result = producer.create( name, 1000 );
+   CHECK_TRUE( result == ring::error::not_a_ring );
+   result = producer.create( name, 1024 );
+   CHECK_TRUE( result == ring::error::none );
+   CHECK_EQUAL( producer.capacity(), 1024 );
+   
+   // a create that fails removes the segment it made,
+   // so the name can be created again
+   const char * huge_name = "/test-runtime-quantity-ring-huge";
+   ring::remove( huge_name );
+   ring huge;
+   result = huge.create( huge_name, std::uint64_t( 1 ) << 50 );
+   CHECK_TRUE( result == ring::error::cannot_open );
+   result = huge.create( huge_name, 64 );
+   CHECK_TRUE( result == ring::error::none );
+   huge.detach();
+   ring::remove( huge_name );
+   
+   // an attach with another base or tag type is refused
+   using int_ring = quantity_shared_ring< int, a >;
+   int_ring wrong_value;
+   auto wrong_value_result = wrong_value.attach( name );
+   CHECK_TRUE( wrong_value_result == int_ring::error::wrong_value_type );
+   using b_ring = quantity_shared_ring< long long, b >;
+   b_ring wrong_tags;
+   auto wrong_tags_result = wrong_tags.attach( name );
+   CHECK_TRUE( wrong_tags_result == b_ring::error::wrong_dimension );
+   
+   ring consumer;
+   result = consumer.attach( name );
+   CHECK_TRUE( result == ring::error::none );
+   CHECK_EQUAL( consumer.capacity(), 1024 );
+   
+   // full and empty
+   auto q = qm::from_raw( 0 );
+   CHECK_TRUE( ! consumer.pop( q ) );
+   quantity_array< long long, a > values( 1100 );
+   for( int i = 0; i < 1100; ++i ){
+      values[ i ] = qm::from_raw( i );
+   }
+   auto pushed = producer.push( values.span() );
+   CHECK_EQUAL( pushed, 1024 );
+   quantity_array< long long, a > back( 2000 );
+   auto popped = consumer.pop( back.span() );
+   CHECK_EQUAL( popped, 1024 );
+   CHECK_EQUAL( back[ 1023 ].raw(), 1023 );
+   
+   // another process produces, this one consumes (timed)
+   const long long n = 200000;
+   const auto start = std::chrono::steady_clock::now();
+   const auto child = fork();
+   if( child == 0 ){
+      ring other;
+      if( other.attach( name ) != ring::error::none ){
+         _exit( 1 );
+      }
+      for( long long i = 0; i < n; ){
+         i += other.push( qm::from_raw( i ) );
+      }
+      _exit( 0 );
+   }
+   
+   // when the ring is empty and the other process has exited
+   // (for instance because its attach() failed), stop waiting
+   long long expected = 0;
+   bool in_order = true;
+   bool exited = false;
+   int status = 0;
+   while( expected < n ){
+      if( consumer.pop( q ) ){
+         in_order = in_order && q.raw() == expected;
+         ++expected;
+      } else if( exited ){
+         break;
+      } else {
+         exited = waitpid( child, & status, WNOHANG ) == child;
+      }
+   }
+   const std::chrono::duration< double > streamed = 
+      std::chrono::steady_clock::now() - start;
+   if( ! exited ){
+      waitpid( child, & status, 0 );
+   }
+   CHECK_EQUAL( expected, n );
+   CHECK_TRUE( in_order );
+   CHECK_EQUAL( status, 0 );
+   
+   // the round trip latency: the other process returns each value
+   // through a second ring
+   const char * reply_name = "/test-runtime-quantity-ring-reply";
+   ring::remove( reply_name );
+   ring replies;
+   result = replies.create( reply_name, 64 );
+   CHECK_TRUE( result == ring::error::none );
+   const long long trips = 20000;
+   const auto echo = fork();
+   if( echo == 0 ){
+      ring in, out;
+      if( in.attach( name ) != ring::error::none 
+         || out.attach( reply_name ) != ring::error::none 
+      ){
+         _exit( 1 );
+      }
+      for( long long i = 0; i < trips; ){
+         auto x = qm::from_raw( 0 );
+         if( in.pop( x ) ){
+            while( ! out.push( x ) ){}
+            ++i;
+         } else {
+            std::this_thread::yield();
+         }
+      }
+      _exit( 0 );
+   }
+   
+   // the consumer side now pops from the reply ring, so that
+   // the other process is the only consumer of the first ring
+   const auto ping = std::chrono::steady_clock::now();
+   bool echoed = true;
+   long long returned = 0;
+   exited = false;
+   for( long long i = 0; i < trips && ! exited; ++i ){
+      while( ! producer.push( qm::from_raw( i ) ) ){}
+      bool popped = false;
+      while( ! ( popped = replies.pop( q ) ) && ! exited ){
+         exited = waitpid( echo, & status, WNOHANG ) == echo;
+         std::this_thread::yield();
+      }
+      if( popped ){
+         echoed = echoed && q.raw() == i;
+         ++returned;
+      }
+   }
+   const std::chrono::duration< double, std::nano > round_trips = 
+      std::chrono::steady_clock::now() - ping;
+   if( ! exited ){
+      waitpid( echo, & status, 0 );
+   }
+   CHECK_EQUAL( returned, trips );
+   CHECK_TRUE( echoed );
+   CHECK_EQUAL( status, 0 );
+   ring::remove( reply_name );
+   std::cout 
+      << "shared ring between processes: " 
+      << n / streamed.count() / 1e6 << " M values/s, round trip "
+      << round_trips.count() / trips << " ns\n";
+   
+   // two producers
+   auto produce = [ & ]( long long first ){
+      ring other;
+      other.attach( name );
+      for( long long i = first; i < n; i += 2 ){
+         while( ! other.push( qm::from_raw( i ) ) ){}
+      }
+   };
+   std::thread t1( produce, 0 ), t2( produce, 1 );
+   long long sum = 0, last_even = -2, last_odd = -1;
+   for( long long i = 0; i < n; ){
+      if( consumer.pop( q ) ){
+         auto & last = q.raw() % 2 == 0 ? last_even : last_odd;
+         in_order = in_order && q.raw() == last + 2;
+         last = q.raw();
+         sum += q.raw();
+         ++i;
+      }
+   }
+   t1.join();
+   t2.join();
+   CHECK_TRUE( in_order );
+   CHECK_EQUAL( sum, n * ( n - 1 ) / 2 );
+   CHECK_TRUE( ! consumer.pop( q ) );
+   
+   ring::remove( name );
+   auto gone = consumer.attach( name );
+   CHECK_TRUE( gone == ring::error::cannot_open );
+   CHECK_EQUAL( consumer.capacity(), 0 );
+   producer.detach();
+   CHECK_EQUAL( producer.capacity(), 0 );
+   
+   // a segment with a bad capacity is not a ring
+   for( unsigned long long capacity : { 0ULL, 1000ULL, 1ULL << 62 } ){
+      const int fd = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0600 );
+      CHECK_TRUE( fd >= 0 );
+      CHECK_EQUAL( ftruncate( fd, 4096 ), 0 );
+      auto words = static_cast< unsigned long long * >( mmap( 
+         nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) );
+      close( fd );
+      words[ 0 ] = 0x474e495251545951;  // ready
+      words[ 1 ] = quantity_file::value_type_code< long long >();
+      words[ 2 ] = type_multiset::fingerprint< a >::value;
+      words[ 3 ] = capacity;
+      munmap( words, 4096 );
+      auto bad = consumer.attach( name );
+      CHECK_TRUE( bad == ring::error::not_a_ring );
+      ring::remove( name );
+   }
+}
+
+
+
+// the text of a to_chars call, or "error"
+template< typename Q >
+std::string chars( const Q & q, std::size_t size = 40 ){
+   char buffer[ 40 ];
+   auto result = to_chars( buffer, buffer + size, q );
+   if( result.ec != std::errc() ){
+      return "error";
+   }
+   return std::string( buffer, result.ptr );
+}
+
+void test_to_chars(){
+   using kg  = type_multiset::one< tag_kg >;
+   using kga = type_multiset::add< a, kg >;
+   using q1  = quantity_implementation< int, type_multiset::add< a2b2, kga > >;
+   using q2  = quantity_implementation< double, type_multiset::multiply< b, -12 > >;
+   using q3  = quantity_implementation< int, type_multiset::empty >;
+   
+   CHECK_EQUAL( chars( qm::from_raw( 42 ) ), "42a" );
+   CHECK_EQUAL( chars( qm::from_raw( -7 ) ), "-7a" );
+   CHECK_EQUAL( chars( q2::from_raw( 2.5 ) ), "2.5b-12" );
+   CHECK_EQUAL( chars( q3::from_raw( 3 ) ), "3" );
+   
+   // the tags are ordered by name
+   CHECK_EQUAL( chars( q1::from_raw( 17 ) ), "17a3b2kg" );
+   
+   // too small buffers
+   CHECK_EQUAL( chars( q2::from_raw( 2.5 ), 7 ), "2.5b-12" );
+   CHECK_EQUAL( chars( q2::from_raw( 2.5 ), 6 ), "error" );
+   CHECK_EQUAL( chars( q2::from_raw( 2.5 ), 2 ), "error" );
+}
+
+
+
+// the result of a from_chars call: the number of characters read,
+// -1 when there is no value, -2 - n when the suffix after a value
+// of n characters doesn't match, or -100 for other errors
+template< typename Q >
+int parse( const std::string & text, Q & q ){
+   auto result = from_chars( text.data(), text.data() + text.size(), q );
+   const int n = result.ptr - text.data();
+   if( result.ec == std::errc::invalid_argument ){
+      return n == 0 ? -1 : -2 - n;
+   }
+   if( result.ec != std::errc() ){
+      return -100;
+   }
+   return n;
+}
+
+void test_from_chars(){
+   using kg  = type_multiset::one< tag_kg >;
+   using kga = type_multiset::add< a, kg >;
+   using q1  = quantity_implementation< int, type_multiset::add< a2b2, kga > >;
+   using q2  = quantity_implementation< double, type_multiset::multiply< b, -12 > >;
+   using q3  = quantity_implementation< int, type_multiset::empty >;
+   
+   auto x = qm::from_raw( 0 );
+   CHECK_EQUAL( parse( "42a", x ), 3 );
+   CHECK_EQUAL( x.raw(), 42 );
+   CHECK_EQUAL( parse( "-7a, 13a", x ), 3 );
+   CHECK_EQUAL( x.raw(), -7 );
+   CHECK_EQUAL( parse( "8a\t", x ), 2 );
+   CHECK_EQUAL( x.raw(), 8 );
+   CHECK_EQUAL( parse( "9a a", x ), -3 );
+   CHECK_EQUAL( x.raw(), 8 );
+   
+   auto y = q2::from_raw( 0 );
+   CHECK_EQUAL( parse( "2.5b-12", y ), 7 );
+   CHECK_EQUAL( y.raw(), 2.5 );
+   
+   auto z = q1::from_raw( 0 );
+   CHECK_EQUAL( parse( "17a3b2kg ", z ), 8 );
+   CHECK_EQUAL( z.raw(), 17 );
+   
+   auto w = q3::from_raw( 0 );
+   CHECK_EQUAL( parse( "5", w ), 1 );
+   CHECK_EQUAL( parse( "5a", w ), -3 );
+   CHECK_EQUAL( w.raw(), 5 );
+   
+   // errors don't change the quantity
+   x = qm::from_raw( 1 );
+   CHECK_EQUAL( parse( "42b", x ), -4 );
+   CHECK_EQUAL( parse( "42a2", x ), -4 );
+   CHECK_EQUAL( parse( "42", x ), -4 );
+   CHECK_EQUAL( parse( "a", x ), -1 );
+   CHECK_EQUAL( parse( "", x ), -1 );
+   CHECK_EQUAL( parse( "99999999999999999999a", x ), -100 );
+   CHECK_EQUAL( x.raw(), 1 );
+   
+   // to_chars and from_chars round-trip
+   const auto v = q2::from_raw( 0.1 / 3 );
+   CHECK_EQUAL( parse( chars( v ), y ), (int) chars( v ).size() );
+   CHECK_TRUE( y.raw() == v.raw() );
+
+   // spaced and reordered tags
+   CHECK_EQUAL( parse( "18 a3 b2 kg, 3", z ), 11 );
+   CHECK_EQUAL( z.raw(), 18 );
+   CHECK_EQUAL( parse( "19 kg b^2 a^3", z ), 13 );
+   CHECK_EQUAL( z.raw(), 19 );
+   CHECK_EQUAL( parse( "20b2kga3", z ), 8 );
+   CHECK_EQUAL( z.raw(), 20 );
+   CHECK_EQUAL( parse( "21 a kg a2 b3 b-1", z ), 17 );
+   CHECK_EQUAL( z.raw(), 21 );
+   CHECK_EQUAL( parse( "22 a3 kg", z ), -4 );
+   CHECK_EQUAL( parse( "22 a3 b2 kg2", z ), -4 );
+   CHECK_EQUAL( parse( "22 a3 b2 kg^", z ), -4 );
+   CHECK_EQUAL( z.raw(), 21 );
+   CHECK_EQUAL( parse( "6 b-12", y ), 6 );
+   CHECK_EQUAL( parse( "6b-6 b-6", y ), 8 );
+
+   // the output of print, in list order
+   using q4 = quantity_implementation< int,
+      type_multiset::add< a, type_multiset::multiply< b, -1 > > >;
+   using q5 = quantity_implementation< int, ba >;
+   std::stringstream s4, s5;
+   s4 << 1;
+   type_multiset::print< q4::tags >( s4 );
+   s5 << 2;
+   type_multiset::print< q5::tags >( s5 );
+   auto u = q4::from_raw( 0 );
+   CHECK_EQUAL( s4.str(), "1b-1a" );
+   CHECK_EQUAL( parse( s4.str(), u ), 5 );
+   CHECK_EQUAL( u.raw(), 1 );
+   auto t = q5::from_raw( 0 );
+   CHECK_EQUAL( s5.str(), "2ba" );
+   CHECK_EQUAL( parse( s5.str(), t ), 3 );
+   CHECK_EQUAL( parse( chars( q5::from_raw( 3 ) ), t ), 3 );
+   CHECK_EQUAL( t.raw(), 3 );
+}
+
+
+
+// the text of a to_chars call with a unit style, or "error"
+template< typename Q, typename... Options >
+std::string styled( std::size_t size, const Q & q, Options... options ){
+   char buffer[ 40 ];
+   auto result = to_chars( buffer, buffer + size, q, options... );
+   if( result.ec != std::errc() ){
+      return "error";
+   }
+   return std::string( buffer, result.ptr );
+}
+
+void test_format(){
+   using kg  = type_multiset::one< tag_kg >;
+   using kga = type_multiset::add< a, kg >;
+   using q1  = quantity_implementation< int, type_multiset::add< a2b2, kga > >;
+   using q2  = quantity_implementation< double, type_multiset::multiply< b, -12 > >;
+   using q3  = quantity_implementation< int, type_multiset::empty >;
+   const auto compact  = quantity_format::unit::compact;
+   const auto exponent = quantity_format::unit::exponent;
+   const auto none     = quantity_format::unit::none;
+   
+   std::string s;
+   quantity_format::write_unit< type_multiset::add< a2b2, kga > >( 
+      std::back_inserter( s ), exponent );
+   CHECK_EQUAL( s, " a^3 b^2 kg" );
+   
+   CHECK_EQUAL( styled( 40, q1::from_raw( 17 ), compact ), "17a3b2kg" );
+   CHECK_EQUAL( styled( 40, q1::from_raw( 17 ), exponent ), "17 a^3 b^2 kg" );
+   CHECK_EQUAL( styled( 40, q1::from_raw( 17 ), none ), "17" );
+   CHECK_EQUAL( styled( 40, q2::from_raw( 2.5 ), exponent ), "2.5 b^-12" );
+   CHECK_EQUAL( styled( 40, q3::from_raw( 3 ), exponent ), "3" );
+   
+   // format and precision of the value
+   CHECK_EQUAL( styled( 40, q2::from_raw( 2.5 ), std::chars_format::fixed, 3 ), 
+      "2.500b-12" );
+   CHECK_EQUAL( styled( 40, q2::from_raw( 1500.0 ), 
+      std::chars_format::scientific, 1, exponent ), "1.5e+03 b^-12" );
+   
+   // too small buffers
+   CHECK_EQUAL( styled( 13, q1::from_raw( 17 ), exponent ), "17 a^3 b^2 kg" );
+   CHECK_EQUAL( styled( 12, q1::from_raw( 17 ), exponent ), "error" );
+   CHECK_EQUAL( styled( 1, q1::from_raw( 17 ), none ), "error" );
+
+#ifdef __cpp_lib_format
+   // std::format, with each unit style
+   CHECK_EQUAL( std::format( "{}", q1::from_raw( 17 ) ), "17a3b2kg" );
+   CHECK_EQUAL( std::format( "{:c|}", q1::from_raw( 17 ) ), "17a3b2kg" );
+   CHECK_EQUAL( std::format( "{:e|}", q1::from_raw( 17 ) ), "17 a^3 b^2 kg" );
+   CHECK_EQUAL( std::format( "{:n|}", q1::from_raw( 17 ) ), "17" );
+   CHECK_EQUAL( std::format( "{:n|>6}", q1::from_raw( 17 ) ), "    17" );
+   CHECK_EQUAL( std::format( "{:.2f}", q2::from_raw( 2.5 ) ), "2.50b-12" );
+   CHECK_EQUAL( std::format( "{:e|.1f}", q2::from_raw( 2.5 ) ), "2.5 b^-12" );
+   CHECK_EQUAL( std::format( "[{:e|}]", q3::from_raw( 3 ) ), "[3]" );
+#endif
+}
+
+
+
+// parse a CSV text into a table of one or two columns
+template< typename Table >
+quantity_csv::error parse_csv( const std::string & text, Table & table ){
+   return quantity_csv::parse( 
+      quantity_parallel::seq, text.data(), text.size(), table );
+}
+
+void test_csv(){
+   using qd  = quantity_implementation< double, ab2 >;
+   using qi  = quantity_implementation< int, type_multiset::empty >;
+   using table_type = quantity_table< qm, qd, qi >;
+   const char * path = "test-runtime-quantity-csv.tmp";
+   
+   // a file that is large enough to be read in several chunks
+   const int n = 200000;
+   std::string text = "time [a], force[ab2],count\n";
+   for( int i = 0; i < n; ++i ){
+      text += std::to_string( i ) + ", " + std::to_string( i / 4.0 ) 
+         + "," + std::to_string( -i ) + ( i % 3 == 0 ? "\r\n" : "\n" );
+      if( i % 1000 == 0 ){
+         text += "\n";
+      }
+   }
+   FILE * f = fopen( path, "wb" );
+   fwrite( text.data(), 1, text.size(), f );
+   fclose( f );
+   
+   table_type table, parallel_table;
+   auto result = quantity_csv::read( path, table );
+   CHECK_TRUE( result == quantity_csv::error::none );
+   result = quantity_csv::read( quantity_parallel::par, path, parallel_table );
+   CHECK_TRUE( result == quantity_csv::error::none );
+   CHECK_EQUAL( table.size(), n );
+   CHECK_EQUAL( parallel_table.size(), n );
+   bool same = true;
+   for( int i = 0; i < n; ++i ){
+      same = same
+         && table[ i ].get< 0 >().raw() == i
+         && table[ i ].get< 1 >().raw() == i / 4.0
+         && table[ i ].get< 2 >().raw() == -i
+         && parallel_table[ i ].get< 0 >().raw() == i
+         && parallel_table[ i ].get< 1 >().raw() == i / 4.0
+         && parallel_table[ i ].get< 2 >().raw() == -i;
+   }
+   CHECK_TRUE( same );
+   ::unlink( path );
+   
+   result = quantity_csv::read( path, table );
+   CHECK_TRUE( result == quantity_csv::error::cannot_open );
+   
+   // header errors
+   quantity_table< qm, qi > small;
+   result = parse_csv( "t[a]\n1\n", small );
+   CHECK_TRUE( result == quantity_csv::error::wrong_columns );
+   result = parse_csv( "t[b],n\n1,2\n", small );
+   CHECK_TRUE( result == quantity_csv::error::wrong_unit );
+   result = parse_csv( "t,n\n1,2\n", small );
+   CHECK_TRUE( result == quantity_csv::error::wrong_unit );
+   result = parse_csv( "t[a],n[]\n1,2\n", small );
+   CHECK_TRUE( result == quantity_csv::error::none );
+   CHECK_EQUAL( small.size(), 1 );
+   
+   // row errors
+   result = parse_csv( "t[a],n\n1,2\n3\n", small );
+   CHECK_TRUE( result == quantity_csv::error::wrong_columns );
+   result = parse_csv( "t[a],n\n1,2,3\n", small );
+   CHECK_TRUE( result == quantity_csv::error::wrong_columns );
+   result = parse_csv( "t[a],n\n1,2.5\n", small );
+   CHECK_TRUE( result == quantity_csv::error::bad_value );
+   result = parse_csv( "t[a],n\n1,x\n", small );
+   CHECK_TRUE( result == quantity_csv::error::bad_value );
+   
+   // no rows
+   result = parse_csv( "t[a],n", small );
+   CHECK_TRUE( result == quantity_csv::error::none );
+   CHECK_EQUAL( small.size(), 0 );
+}
+
+
+
+// the contents of a file
+std::string file_text( const char * path ){
+   std::string text;
+   FILE * f = fopen( path, "rb" );
+   char buffer[ 4096 ];
+   std::size_t n;
+   while( ( n = fread( buffer, 1, sizeof( buffer ), f ) ) > 0 ){
+      text.append( buffer, n );
+   }
+   fclose( f );
+   return text;
+}
+
+void test_export(){
+   using qd  = quantity_implementation< double, ab2 >;
+   using qi  = quantity_implementation< int, type_multiset::empty >;
+   using table_type = quantity_table< qm, qd, qi >;
+   const char * path = "test-runtime-quantity-export.tmp";
+   const char * names[] = { "time", "force", "count" };
+   
+   table_type table;
+   table.push_back( qm::from_raw( 1 ), qd::from_raw( 0.5 ), qi::from_raw( -3 ) );
+   table.push_back( qm::from_raw( 2 ), qd::from_raw( 1e300 * 1e300 ), qi::from_raw( 4 ) );
+   
+   quantity_export::writer w;
+   auto result = w.open( path );
+   CHECK_TRUE( result == quantity_export::error::none );
+   quantity_export::csv( w, names, table );
+   result = w.close();
+   CHECK_TRUE( result == quantity_export::error::none );
+   CHECK_EQUAL( file_text( path ), 
+      "time[a],force[ab2],count[]\n1,0.5,-3\n2,inf,4\n" );
+   
+   w.open( path );
+   quantity_export::json( w, names, table );
+   w.close();
+   CHECK_EQUAL( file_text( path ), 
+      "{\"columns\":[{\"name\":\"time\",\"unit\":\"a\"},"
+      "{\"name\":\"force\",\"unit\":\"ab2\"},"
+      "{\"name\":\"count\",\"unit\":\"\"}],\n"
+      "\"rows\":[[1,0.5,-3],\n[2,null,4]]}\n" );
+      
+   w.open( path );
+   quantity_export::json( w, "time", table.column< 0 >() );
+   w.close();
+   CHECK_EQUAL( file_text( path ), 
+      "{\"columns\":[{\"name\":\"time\",\"unit\":\"a\"}],\n"
+      "\"rows\":[[1],\n[2]]}\n" );
+   
+   // a large table through a small buffer, read back
+   const int n = 50000;
+   table_type large( n ), back;
+   for( int i = 0; i < n; ++i ){
+      large[ i ].get< 0 >() = qm::from_raw( i * 1000003LL );
+      large[ i ].get< 1 >() = qd::from_raw( i / 7.0 );
+      large[ i ].get< 2 >() = qi::from_raw( -i );
+   }
+   quantity_export::writer small( 200 );
+   small.open( path );
+   quantity_export::csv( small, names, large );
+   result = small.close();
+   CHECK_TRUE( result == quantity_export::error::none );
+   auto read_result = quantity_csv::read( path, back );
+   CHECK_TRUE( read_result == quantity_csv::error::none );
+   CHECK_EQUAL( back.size(), n );
+   bool same = true;
+   for( int i = 0; i < n; ++i ){
+      same = same 
+         && back[ i ].get< 0 >().raw() == large[ i ].get< 0 >().raw()
+         && back[ i ].get< 1 >().raw() == large[ i ].get< 1 >().raw()
+         && back[ i ].get< 2 >().raw() == large[ i ].get< 2 >().raw();
+   }
+   CHECK_TRUE( same );
+   
+   // a span as CSV
+   quantity_array< long long, a > values( 3 );
+   values[ 2 ] = qm::from_raw( 7 );
+   small.open( path );
+   quantity_export::csv( small, "x", values.span() );
+   small.close();
+   CHECK_EQUAL( file_text( path ), "x[a]\n0\n0\n7\n" );
+   ::unlink( path );
+   
+   result = w.open( "no-such-directory/test.tmp" );
+   CHECK_TRUE( result == quantity_export::error::cannot_open );
+}
+
+
+
+void test_log(){
+   using qd = quantity_implementation< double, ab2 >;
+   using qb = quantity_implementation< unsigned char, b >;
+   const char * path = "test-runtime-quantity-log.tmp";
+   const char * text_path = "test-runtime-quantity-log-text.tmp";
+   static const quantity_log::site< double, ab2 > pressure( "pressure {} at inlet" );
+   static const quantity_log::site< long long, a > count( "count" );
+   static const quantity_log::site< unsigned char, b > level( "level={}" );
+   
+   quantity_log::logger log( 100 );
+   auto result = log.open( path );
+   CHECK_TRUE( result == quantity_log::error::none );
+   for( int i = 0; i < 10; ++i ){
+      log.write( pressure, qd::from_raw( i / 2.0 ), 1000 + i );
+      log.write( count, qm::from_raw( -i ), 2000 + i );
+   }
+   log.write( level, qb::from_raw( 200 ), 3000 );
+   
+   // the buffers that were full are written by the writer thread,
+   // flush() also writes the current one, and waits for both
+   log.flush();
+   CHECK_EQUAL( file_text( path ).size(), 505 );
+   log.write( count, qm::from_raw( 42 ) );
+   result = log.close();
+   CHECK_TRUE( result == quantity_log::error::none );
+   
+   const auto data = file_text( path );
+   quantity_log::decoder decoder( 
+      reinterpret_cast< const unsigned char * >( data.data() ), data.size() );
+   quantity_log::event e;
+   result = decoder.read( e );
+   CHECK_TRUE( result == quantity_log::error::none );
+   CHECK_EQUAL( e.timestamp, 1000 );
+   CHECK_EQUAL( e.text, "pressure 0ab2 at inlet" );
+   result = decoder.read( e );
+   CHECK_EQUAL( e.timestamp, 2000 );
+   CHECK_EQUAL( e.text, "count 0a" );
+   for( int i = 0; i < 18; ++i ){
+      result = decoder.read( e );
+   }
+   CHECK_EQUAL( e.text, "count -9a" );
+   result = decoder.read( e );
+   CHECK_EQUAL( e.text, "level=200b" );
+   result = decoder.read( e );
+   CHECK_TRUE( result == quantity_log::error::none );
+   CHECK_EQUAL( e.text, "count 42a" );
+   CHECK_TRUE( e.timestamp > 3000 );
+   result = decoder.read( e );
+   CHECK_TRUE( result == quantity_log::error::end );
+   
+   // a truncated log
+   quantity_log::decoder cut( 
+      reinterpret_cast< const unsigned char * >( data.data() ), data.size() - 1 );
+   int n = 0;
+   while( ( result = cut.read( e ) ) == quantity_log::error::none ){
+      ++n;
+   }
+   CHECK_EQUAL( n, 21 );
+   CHECK_TRUE( result == quantity_log::error::truncated );
+   
+   // decode to a text file
+   result = quantity_log::decode( path, text_path );
+   CHECK_TRUE( result == quantity_log::error::none );
+   const auto text = file_text( text_path );
+   CHECK_EQUAL( text.substr( 0, 48 ), 
+      "1000: pressure 0ab2 at inlet\n2000: count 0a\n1001" );
+   ::unlink( path );
+   ::unlink( text_path );
+   
+   result = quantity_log::decode( path, text_path );
+   CHECK_TRUE( result == quantity_log::error::cannot_open );
+}
+
+
+
+// call f( t ) in n threads, t = 0 .. n - 1
+template< typename F >
+void in_threads( int n, F f ){
+   std::vector< std::thread > threads;
+   for( int t = 0; t < n; ++t ){
+      threads.emplace_back( f, t );
+   }
+   for( auto & t : threads ){
+      t.join();
+   }
+}
+
+void test_atomic(){
+   using qd = quantity_implementation< double, ab >;
+   using qd2 = quantity_implementation< double, ba >;
+   
+   quantity_atomic< long long, a > count;
+   CHECK_TRUE( count.is_lock_free() );
+   CHECK_EQUAL( count.load().raw(), 0 );
+   count.store( qm::from_raw( 5 ) );
+   auto old = count.exchange( qm::from_raw( 7 ) );
+   CHECK_EQUAL( old.raw(), 5 );
+   old = count.fetch_add( qm::from_raw( 3 ) );
+   CHECK_EQUAL( old.raw(), 7 );
+   old = count.fetch_sub( qm::from_raw( 4 ) );
+   CHECK_EQUAL( old.raw(), 10 );
+   CHECK_EQUAL( count.load().raw(), 6 );
+   
+   auto expected = qm::from_raw( 1 );
+   auto done = count.compare_exchange_strong( expected, qm::from_raw( 2 ) );
+   CHECK_TRUE( ! done );
+   CHECK_EQUAL( expected.raw(), 6 );
+   done = count.compare_exchange_strong( expected, qm::from_raw( 2 ) );
+   CHECK_TRUE( done );
+   CHECK_EQUAL( count.load().raw(), 2 );
+   
+   // concurrent updates, also through an equal tag type
+   quantity_atomic< double, ab > energy( qd::from_raw( 0.5 ) );
+   CHECK_TRUE( energy.is_always_lock_free );
+   in_threads( 4, [ & ]( int t ){
+      for( int i = 0; i < 10000; ++i ){
+         count.fetch_add( qm::from_raw( t + 1 ), std::memory_order_relaxed );
+         energy.fetch_add( qd2::from_raw( 1.0 ) );
+         energy.fetch_sub( qd::from_raw( 0.5 ) );
+      }
+   } );
+   CHECK_EQUAL( count.load().raw(), 2 + 10000 * ( 1 + 2 + 3 + 4 ) );
+   CHECK_EQUAL( energy.load().raw(), 0.5 + 4 * 10000 * 0.5 );
+}
+
+
+
+void test_sharded_counter(){
+   using qd = quantity_implementation< double, ab >;
+   using qd2 = quantity_implementation< double, ba >;
+   
+   quantity_sharded_counter< long long, a > packets( 3 );
+   CHECK_EQUAL( packets.size(), 4 );
+   CHECK_EQUAL( packets.read().raw(), 0 );
+   packets.add( qm::from_raw( 5 ) );
+   packets.sub( qm::from_raw( 2 ) );
+   CHECK_EQUAL( packets.read().raw(), 3 );
+   
+   quantity_sharded_counter< double, ab > energy;
+   CHECK_TRUE( energy.size() >= 1 );
+   in_threads( 6, [ & ]( int t ){
+      for( int i = 0; i < 10000; ++i ){
+         packets.add( qm::from_raw( t ) );
+         energy.add( qd2::from_raw( 0.25 ) );
+      }
+   } );
+   CHECK_EQUAL( packets.read().raw(), 3 + 10000 * 15 );
+   CHECK_EQUAL( energy.read().raw(), 6 * 10000 * 0.25 );
+   energy.clear();
+   CHECK_EQUAL( energy.read().raw(), 0.0 );
+   energy.add( qd::from_raw( 1.5 ) );
+   CHECK_EQUAL( energy.read().raw(), 1.5 );
+}
+
+
+
+void test_ring(){
+   using qa16 = quantity_implementation< short, a >;
+   using ring_type = quantity_ring< short, a, 64 >;
+   static ring_type ring;
+   
+   auto q = qa16::from_raw( 0 );
+   CHECK_TRUE( ring.empty() );
+   CHECK_TRUE( ! ring.pop( q ) );
+   auto done = ring.push( qa16::from_raw( 12 ) );
+   CHECK_TRUE( done );
+   CHECK_EQUAL( ring.size(), 1 );
+   done = ring.pop( q );
+   CHECK_TRUE( done );
+   CHECK_EQUAL( q.raw(), 12 );
+   
+   // batches, wrapping around
+   quantity_array< short, a > in( 100 ), out( 100 );
+   for( int i = 0; i < 100; ++i ){
+      in[ i ] = qa16::from_raw( i );
+   }
+   auto n = ring.push( in.span() );
+   CHECK_EQUAL( n, 64 );
+   done = ring.push( qa16::from_raw( 1 ) );
+   CHECK_TRUE( ! done );
+   n = ring.pop( out.span().subspan( 0, 10 ) );
+   CHECK_EQUAL( n, 10 );
+   n = ring.push( in.span().subspan( 64, 36 ) );
+   CHECK_EQUAL( n, 10 );
+   n = ring.pop( out.span().subspan( 10, 90 ) );
+   CHECK_EQUAL( n, 64 );
+   CHECK_EQUAL( out[ 73 ].raw(), 73 );
+   CHECK_TRUE( ring.empty() );
+   
+   // a producer and a consumer thread
+   const int total = 200000;
+   bool in_order = true;
+   std::thread consumer( [ & ](){
+      quantity_array< short, a > buffer( 16 );
+      int expected = 0;
+      while( expected < total ){
+         const auto n = ring.pop( buffer.span() );
+         for( std::size_t i = 0; i < n; ++i ){
+            in_order = in_order && buffer[ i ].raw() == short( expected++ );
+         }
+         if( n == 0 ){
+            std::this_thread::yield();
+         }
+      }
+   } );
+   for( int i = 0; i < total; ){
+      if( ring.size() == ring.capacity ){
+         std::this_thread::yield();
+      } else if( i % 3 == 0 ){
+         i += ring.push( qa16::from_raw( short( i ) ) );
+      } else {
+         quantity_array< short, a > batch( 5 );
+         for( int j = 0; j < 5; ++j ){
+            batch[ j ] = qa16::from_raw( short( i + j ) );
+         }
+         const auto count = total - i < 5 ? total - i : 5;
+         i += ring.push( batch.span().subspan( 0, count ) );
+      }
+   }
+   consumer.join();
+   CHECK_TRUE( in_order );
+   CHECK_TRUE( ring.empty() );
+}
+
+
+
+void test_seqlock(){
+   using qp = quantity_implementation< double, a >;
+   using qv = quantity_implementation< double, b >;
+   using qc = quantity_implementation< int, c >;
+   struct position {};
+   struct velocity {};
+   struct current {};
+   using state = quantity_seqlock< 
+      quantity_field< position, qp >,
+      quantity_field< velocity, qv >,
+      quantity_field< current, qc > >;
+   
+   static state published;
+   CHECK_EQUAL( published.version(), 0 );
+   auto r = published.read();
+   CHECK_EQUAL( r.get< position >().raw(), 0.0 );
+   
+   state::record_type w;
+   w.get< position >() = qp::from_raw( 1.5 );
+   w.get< current >() = qc::from_raw( -3 );
+   published.publish( w );
+   CHECK_EQUAL( published.version(), 1 );
+   r = published.read();
+   CHECK_EQUAL( r.get< position >().raw(), 1.5 );
+   CHECK_EQUAL( r.get< current >().raw(), -3 );
+   
+   // readers always see a state from a single publish
+   const int publishes = 200000;
+   std::atomic< bool > done{ false };
+   std::atomic< int > torn{ 0 }, reads{ 0 };
+   std::thread writer( [ & ](){
+      state::record_type w;
+      for( int i = 0; i < publishes; ++i ){
+         w.get< position >() = qp::from_raw( i );
+         w.get< velocity >() = qv::from_raw( 2.0 * i );
+         w.get< current >() = qc::from_raw( -i );
+         published.publish( w );
+      }
+      done = true;
+   } );
+   in_threads( 2, [ & ]( int ){
+      while( ! done ){
+         const auto r = published.read();
+         const auto p = r.get< position >().raw();
+         if( r.get< velocity >().raw() != 2 * p 
+            || r.get< current >().raw() != -p 
+         ){
+            ++torn;
+         }
+         ++reads;
+      }
+   } );
+   writer.join();
+   CHECK_EQUAL( torn.load(), 0 );
+   CHECK_EQUAL( published.version(), publishes + 1 );
+   r = published.read();
+   CHECK_EQUAL( r.get< current >().raw(), 1 - publishes );
+}
+
+
+void test_timing(){
+   using quantity_timing::duration;
+   
+   const auto us = quantity_timing::from_chrono( std::chrono::microseconds( 3 ) );
+   CHECK_EQUAL( us.raw(), 3000 );
+   const auto ms = quantity_timing::to_chrono< std::chrono::milliseconds >( 
+      duration::from_raw( 2500000 ) );
+   CHECK_EQUAL( ms.count(), 2 );
+   
+   quantity_timing::histogram h;
+   auto r = h.read();
+   CHECK_EQUAL( r.count, 0 );
+   CHECK_EQUAL( r.max.raw(), 0 );
+   CHECK_EQUAL( r.percentile( 0.5 ).raw(), 0 );
+   for( int i = 1; i <= 100; ++i ){
+      h.add( duration::from_raw( i ) );
+   }
+   h.add( duration::from_raw( 0 ) );
+   r = h.read();
+   CHECK_EQUAL( r.count, 101 );
+   CHECK_EQUAL( r.total.raw(), 5050 );
+   CHECK_EQUAL( r.mean().raw(), 50 );
+   CHECK_EQUAL( r.min.raw(), 0 );
+   CHECK_EQUAL( r.max.raw(), 100 );
+   CHECK_EQUAL( r.bucket[ 0 ], 1 );
+   CHECK_EQUAL( r.bucket[ 1 ], 1 );
+   CHECK_EQUAL( r.bucket[ 7 ], 37 );
+   CHECK_EQUAL( r.percentile( 0.5 ).raw(), 63 );
+   CHECK_EQUAL( r.percentile( 0.99 ).raw(), 100 );
+   h.clear();
+   CHECK_EQUAL( h.read().count, 0 );
+   
+   static quantity_timing::stage work( "work" );
+   in_threads( 4, [ & ]( int t ){
+      for( int i = 0; i < 1000; ++i ){
+         work.add( duration::from_raw( t + 1 ) );
+      }
+   } );
+   {
+      quantity_timing::scope timer( work );
+      CHECK_TRUE( timer.elapsed().raw() >= 0 );
+   }
+   r = work.histogram.read();
+   CHECK_EQUAL( r.count, 4001 );
+   CHECK_TRUE( r.total.raw() >= 10000 );
+   CHECK_EQUAL( r.min.raw(), 1 );
+   
+   const char * path = "test-runtime-quantity-timing.tmp";
+   FILE * f = fopen( path, "w" );
+   quantity_timing::report< std::chrono::nanoseconds >( f );
+   fclose( f );
+   const auto text = file_text( path );
+   CHECK_TRUE( text.find( "[ns]" ) != std::string::npos );
+   CHECK_TRUE( text.find( "work" ) != std::string::npos );
+   CHECK_TRUE( text.find( "4001" ) != std::string::npos );
+   ::unlink( path );
+}
+
+
+void test_statistics(){
+   using qi  = quantity_implementation< int, ab >;
+   using qd  = quantity_implementation< double, ab >;
+   using qd2 = quantity_implementation< double, ba >;
+   using stats = quantity_statistics< double, ab >;
+   
+   stats empty;
+   CHECK_EQUAL( empty.count(), 0 );
+   CHECK_EQUAL( empty.mean().raw(), 0.0 );
+   CHECK_EQUAL( empty.variance().raw(), 0.0 );
+   
+   // the result types carry the tags
+   static_assert( type_multiset::equal< 
+      stats::mean_type::tags, ab >::value, "" );
+   static_assert( type_multiset::equal< 
+      stats::variance_type::tags, type_multiset::add< ab, ab > >::value, "" );
+   
+   stats s;
+   for( double x : { 2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0 } ){
+      s.add( qd2::from_raw( x ) );
+   }
+   CHECK_EQUAL( s.count(), 8 );
+   CHECK_EQUAL( s.mean().raw(), 5.0 );
+   CHECK_EQUAL( s.variance().raw(), 4.0 );
+   CHECK_EQUAL( s.standard_deviation().raw(), 2.0 );
+   CHECK_EQUAL( s.sample_variance().raw(), 32.0 / 7 );
+   CHECK_EQUAL( s.min().raw(), 2.0 );
+   CHECK_EQUAL( s.max().raw(), 9.0 );
+   
+   // large offsets don't cancel the variance
+   quantity_array< double, ab > data;
+   for( int i = 0; i < 100003; ++i ){
+      data.push_back( qd::from_raw( 1e9 + ( i % 2 == 0 ? 1.0 : -1.0 ) ) );
+   }
+   data[ 5000 ] = qd::from_raw( 1e9 + 7 );
+   stats bulk;
+   bulk.add( data.span() );
+   CHECK_EQUAL( bulk.count(), 100003 );
+   CHECK_TRUE( std::abs( bulk.mean().raw() - ( 1e9 + 7.0 / 100003 ) ) < 1e-6 );
+   CHECK_TRUE( std::abs( bulk.variance().raw() - 1.00047 ) < 1e-4 );
+   CHECK_EQUAL( bulk.min().raw(), 1e9 - 1 );
+   CHECK_EQUAL( bulk.max().raw(), 1e9 + 7 );
+   
+   stats one_by_one;
+   for( const auto & q : data ){
+      one_by_one.add( q );
+   }
+   CHECK_TRUE( std::abs( bulk.variance().raw() 
+      - one_by_one.variance().raw() ) < 1e-9 );
+   
+   stats parallel;
+   parallel.add( quantity_parallel::par, data.span() );
+   CHECK_EQUAL( parallel.count(), 100003 );
+   CHECK_TRUE( std::abs( bulk.mean().raw() - parallel.mean().raw() ) < 1e-6 );
+   CHECK_TRUE( std::abs( bulk.variance().raw() 
+      - parallel.variance().raw() ) < 1e-9 );
+   CHECK_EQUAL( parallel.max().raw(), 1e9 + 7 );
+   
+   // merging the statistics of two halves
+   stats first, second;
+   first.add( quantity_span< const qd >( data.data(), 50000 ) );
+   second.add( quantity_span< const qd >( data.data() + 50000, 50003 ) );
+   first.merge( second );
+   CHECK_EQUAL( first.count(), 100003 );
+   CHECK_TRUE( std::abs( bulk.variance().raw() 
+      - first.variance().raw() ) < 1e-9 );
+   first.clear();
+   CHECK_EQUAL( first.count(), 0 );
+   
+   // integer samples
+   quantity_statistics< int, ab > counts;
+   counts.add( qi::from_raw( 1 ) );
+   counts.add( qi::from_raw( 2 ) );
+   CHECK_EQUAL( counts.mean().raw(), 1.5 );
+   CHECK_EQUAL( counts.variance().raw(), 0.25 );
+   CHECK_EQUAL( counts.max().raw(), 2 );
+}
+
 
 
 // ==========================================================================
@@ -475,10 +2112,38 @@ int main(){
    test_multiset_multiply();
    test_multiset_add_prune();
    test_multiset_equal();
+   test_multiset_fingerprint();
+   test_multiset_name();
 	
    test_constructor();
    test_divide();
    test_multiply();
+   
+   test_scan();
+   test_integrate();
+   test_parallel_algorithms();
+   test_expressions();
+   test_table();
+   test_record();
+   test_packed_array();
+   test_codec();
+   test_file();
+   test_file_zones();
+   test_file_zones_nan();
+   test_serialize();
+   test_shared_ring();
+   test_to_chars();
+   test_from_chars();
+   test_format();
+   test_csv();
+   test_export();
+   test_log();
+   test_atomic();
+   test_sharded_counter();
+   test_ring();
+   test_seqlock();
+   test_timing();
+   test_statistics();
 
 
    return test_end();